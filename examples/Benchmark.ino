@@ -0,0 +1,101 @@
+// Measures the DateTime/TimeSpan hot paths and prints one CSV line per
+// benchmark: name,iterations,unit,total,per_op
+// On STM32 (Cortex-M3 and up) the unit is CPU cycles from DWT CYCCNT,
+// elsewhere it is microseconds from micros().
+#include <Arduino.h>
+#include <PCF85263.h>
+
+#define ITERATIONS 1000
+
+#if defined(ARDUINO_ARCH_STM32) && defined(DWT)
+#define BENCH_UNIT "cycles"
+static void counterBegin(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+static uint32_t counterRead(void) { return DWT->CYCCNT; }
+#else
+#define BENCH_UNIT "us"
+static void counterBegin(void) {}
+static uint32_t counterRead(void) { return micros(); }
+#endif
+
+// Results are folded into this so the compiler cannot drop the work
+volatile uint32_t sink;
+
+// Inputs change every iteration and are read through volatiles, so the
+// compiler can neither hoist a call out of the loop nor fold it
+#define INPUTS 16
+DateTime dates[INPUTS];
+const char *volatile date_str = __DATE__;
+const char *volatile time_str = __TIME__;
+const __FlashStringHelper *volatile date_flash = F(__DATE__);
+const __FlashStringHelper *volatile time_flash = F(__TIME__);
+const char *const isos[4] = {"2023-01-21T03:04:05", "1999-12-31T23:59:59",
+                             "2000-02-29T12:00:00", "2099-07-04T00:00:01"};
+volatile uint8_t input_offset = 0;
+
+static void report(const char *name, uint32_t total)
+{
+    Serial.print(name);
+    Serial.print(',');
+    Serial.print(ITERATIONS);
+    Serial.print(',');
+    Serial.print(BENCH_UNIT);
+    Serial.print(',');
+    Serial.print(total);
+    Serial.print(',');
+    Serial.println((float)total / ITERATIONS, 2);
+}
+
+#define BENCH(name, body)                                 \
+    do {                                                  \
+        uint32_t start = counterRead();                   \
+        for (uint32_t i = 0; i < ITERATIONS; i++) {       \
+            body;                                         \
+        }                                                 \
+        report(name, counterRead() - start);              \
+    } while (0)
+
+void setup(void)
+{
+    Serial.begin(115200);
+    while (!Serial) delay(10);
+    counterBegin();
+
+    // Spread the inputs over several decades so no single date is favoured
+    const uint32_t base = 1262304000UL; // 2010-01-01
+    for (uint8_t k = 0; k < INPUTS; k++)
+        dates[k] = DateTime(base + k * 97331711UL);
+    const DateTimeFormat format("YYYY-MM-DD hh:mm:ss");
+    char buffer[PCF85263_FORMAT_MAX_LEN];
+
+    Serial.println("name,iterations,unit,total,per_op");
+
+#define BENCH_INPUT(i) dates[((i) + input_offset) % INPUTS]
+    BENCH("DateTime(uint32_t)", sink += DateTime(base + i * 997331UL).day());
+    BENCH("unixtime", sink += BENCH_INPUT(i).unixtime());
+    BENCH("secondstime", sink += BENCH_INPUT(i).secondstime());
+    BENCH("dayOfTheWeek", sink += BENCH_INPUT(i).dayOfTheWeek());
+    BENCH("isValid", sink += BENCH_INPUT(i).isValid());
+    BENCH("operator<", sink += BENCH_INPUT(i) < BENCH_INPUT(i + 1));
+    BENCH("TimeSpan add", sink += (BENCH_INPUT(i) + TimeSpan(i)).second());
+    BENCH("toString(in place)", {
+        strcpy(buffer, "YYYY-MM-DD hh:mm:ss");
+        sink += BENCH_INPUT(i).toString(buffer)[3];
+    });
+    BENCH("toString(DateTimeFormat)", sink += BENCH_INPUT(i).toString(buffer, sizeof(buffer), format)[3]);
+    BENCH("timestamp(char *)", sink += BENCH_INPUT(i).timestamp(buffer, sizeof(buffer))[3]);
+    BENCH("timestamp(String)", sink += BENCH_INPUT(i).timestamp().length());
+    BENCH("DateTime(__DATE__, __TIME__)", sink += DateTime(date_str, time_str).day());
+    BENCH("DateTime(F(__DATE__), F(__TIME__))", sink += DateTime(date_flash, time_flash).day());
+    BENCH("DateTime(iso8601)", sink += DateTime(isos[(i + input_offset) % 4]).day());
+
+    Serial.println("done");
+}
+
+void loop(void)
+{
+}
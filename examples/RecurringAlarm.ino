@@ -0,0 +1,33 @@
+#include <Arduino.h>
+#include <PCF85263.h>
+
+PCF85263 rtc;
+
+void setup(void)
+{
+    Wire.begin();
+    Serial.begin(115200);
+
+    if(!rtc.begin())
+    {
+        Serial.println("RTC not found! Check your wiring.");
+        Serial.flush();
+        while (1) delay(10);
+    }
+
+    rtc.start();
+    rtc.configure();
+
+    // Alarm1 fires every minute at :30, Alarm2 every Monday at 06:00.
+    // Both repeat in hardware, so they only need to be programmed once.
+    rtc.setAlarms(AlarmSpec::everyMinuteAt(30), AlarmSpec::weeklyAt(1, 6, 0));
+
+    // Route both alarms to INTA (pulse mode)
+    rtc.setInterrupts(PCF85263::INT_A, PCF85263_INT_PULSE | PCF85263_INT_ALARM1 | PCF85263_INT_ALARM2);
+}
+
+void loop(void)
+{
+  Serial.println(rtc.now().timestamp());
+  delay(1000);
+}
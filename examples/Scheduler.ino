@@ -0,0 +1,56 @@
+#include <Arduino.h>
+#include <PCF85263.h>
+#include <PCF85263Scheduler.h>
+
+#define INTA_PIN 2
+
+PCF85263 rtc;
+PCF85263Scheduler scheduler;
+
+void onAlarm(void)
+{
+    scheduler.isr();
+}
+
+void sample(uint8_t job, const DateTime &now)
+{
+    Serial.print("sample  ");
+    Serial.println(now.timestamp());
+}
+
+void uplink(uint8_t job, const DateTime &now)
+{
+    Serial.print("uplink  ");
+    Serial.println(now.timestamp());
+}
+
+void setup(void)
+{
+    Wire.begin();
+    Serial.begin(115200);
+
+    if(!rtc.begin())
+    {
+        Serial.println("RTC not found! Check your wiring.");
+        Serial.flush();
+        while (1) delay(10);
+    }
+
+    rtc.start();
+    rtc.configure();
+
+    // Route both alarms to INTA (pulse mode), the scheduler owns them
+    rtc.setInterrupts(PCF85263::INT_A, PCF85263_INT_PULSE | PCF85263_INT_ALARM1 | PCF85263_INT_ALARM2);
+    pinMode(INTA_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(INTA_PIN), onAlarm, FALLING);
+
+    scheduler.begin(rtc);
+    scheduler.every(TimeSpan(15), sample);
+    scheduler.every(TimeSpan(0, 0, 5, 0), uplink);
+}
+
+void loop(void)
+{
+  scheduler.service();
+  // enter a low power mode here, INTA wakes the MCU for the next job
+}
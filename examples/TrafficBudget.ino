@@ -0,0 +1,48 @@
+// Runs the driver against the simulated device and prints the bus
+// traffic of each API call, no RTC needs to be connected.
+#include <Arduino.h>
+#include <PCF85263.h>
+#include <PCF85263Sim.h>
+
+PCF85263_SimTransport sim;
+PCF85263 rtc;
+
+void report(const char *name, const PCF85263_BusCounters &before, uint32_t budget)
+{
+    PCF85263_BusCounters used = sim.since(before);
+    Serial.print(name);
+    Serial.print(": ");
+    Serial.print(used.transactions);
+    Serial.print(" transactions, ");
+    Serial.print(used.bytes_written + used.bytes_read);
+    Serial.print(" bytes");
+    Serial.println(used.transactions <= budget ? "" : "  OVER BUDGET");
+}
+
+void setup(void)
+{
+    Serial.begin(115200);
+    rtc.begin(sim, true);
+
+    PCF85263_BusCounters before = sim.counters();
+    rtc.configure();
+    report("configure()", before, 2);
+
+    before = sim.counters();
+    rtc.adjust(DateTime(2023, 1, 21, 3, 0, 0));
+    report("adjust()", before, 1);
+
+    before = sim.counters();
+    rtc.setInterrupts(PCF85263_INT_PULSE | PCF85263_INT_ALARM1, PCF85263_INT_BATTERY);
+    report("setInterrupts()", before, 1);
+
+    sim.advance(100);
+    before = sim.counters();
+    DateTime now = rtc.now();
+    report("now()", before, 1);
+    Serial.println(now.timestamp());
+}
+
+void loop(void)
+{
+}
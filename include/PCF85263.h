@@ -22,7 +22,20 @@
 #include <SPI.h>
 #include <Wire.h>
 
+/* Build with -DPCF85263_NO_HEAP to keep the driver off the heap: the
+   `String` returning calls are deleted, so any use of them fails to
+   compile. Set it for every translation unit including this header. */
+
 class TimeSpan;
+class DateTimeFormat;
+
+/*!
+    Elapsed time of the PCF85263 stopwatch in hundredths of a second. The
+    counter reaches 999,999 h, which does not fit into 32 bits.
+*/
+typedef uint64_t StopwatchTicks;
+
+#define PCF85263_STOPWATCH_INVALID  (~(StopwatchTicks)0)  //< readStopwatch() result when the device could not be read
 
 #define SECONDS_PER_DAY             86400L    //< 60 * 60 * 24
 #define SECONDS_FROM_1970_TO_2000   946684800 //< Unixtime for 2000-01-01 00:00:00, useful for initialization
@@ -31,60 +44,148 @@ class TimeSpan;
 class DateTime {
 public:
   DateTime(uint32_t t = SECONDS_FROM_1970_TO_2000);
-  DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0,
-           uint8_t min = 0, uint8_t sec = 0);
-  DateTime(const DateTime &copy);
-  DateTime(const char *date, const char *time);
+  /*!
+      @brief  Constructor from (year, month, day, hour, minute, second).
+      @warning If the provided parameters are not valid (e.g. 31 February),
+             the constructed DateTime will be invalid.
+      @see   The `isValid()` method can be used to test whether the
+             constructed DateTime is valid.
+      @param year Either the full year (range: 2000--2099) or the offset from
+          year 2000 (range: 0--99).
+      @param month Month number (1--12).
+      @param day Day of the month (1--31).
+      @param hour,min,sec Hour (0--23), minute (0--59) and second (0--59).
+  */
+  constexpr DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0,
+                     uint8_t min = 0, uint8_t sec = 0)
+      : yOff(year >= 2000U ? year - 2000U : year), m(month), d(day), hh(hour),
+        mm(min), ss(sec) {}
+  /*!
+      @brief  Copy constructor, trivial so that assignment stays implicit.
+  */
+  constexpr DateTime(const DateTime &) = default;
+  /*!
+      @brief  Constructor for generating the build time.
+      This constructor expects its parameters to be strings in the format
+      generated by the compiler's preprocessor macros `__DATE__` and
+      `__TIME__`. It is `constexpr`, so
+      ```
+      constexpr DateTime buildTime(__DATE__, __TIME__);
+      ```
+      is folded into a constant and neither the strings nor the parser end
+      up in the image.
+      @param date Date string, e.g. "Apr 16 2020".
+      @param time Time string, e.g. "18:34:56".
+  */
+  constexpr DateTime(const char *date, const char *time)
+      : yOff(conv2d(date[9], date[10])), m(month_from_name(date)),
+        d(conv2d(date[4], date[5])), hh(conv2d(time[0], time[1])),
+        mm(conv2d(time[3], time[4])), ss(conv2d(time[6], time[7])) {}
   DateTime(const __FlashStringHelper *date, const __FlashStringHelper *time);
-  DateTime(const char *iso8601date);
+  /*!
+      @brief  Constructor for creating a DateTime from an ISO8601 date string.
+      This constructor expects its parameters to be a string in the
+      https://en.wikipedia.org/wiki/ISO_8601 format, e.g:
+      "2020-06-25T15:29:37"
+      Usage:
+      ```
+      DateTime dt("2020-06-25T15:29:37");
+      ```
+      Missing trailing fields default to "2000-01-01T00:00:00". The
+      constructor is `constexpr`, so literal stamps are folded at build
+      time.
+      @note The year must be > 2000, as only the yOff is considered.
+      @param iso8601date
+             A dateTime string in iso8601 format,
+             e.g. "2020-06-25T15:29:37".
+  */
+  constexpr DateTime(const char *iso8601date)
+      : DateTime(IsoTag(), iso8601date, iso_length(iso8601date, 0)) {}
   bool isValid() const;
   char *toString(char *buffer) const;
+  char *toString(char *buffer, size_t len, const DateTimeFormat &format) const;
 
   /*!
       @brief  Return the year.
       @return Year (range: 2000--2099).
   */
-  uint16_t year() const { return 2000U + yOff; }
+  constexpr uint16_t year() const { return 2000U + yOff; }
   /*!
       @brief  Return the month.
       @return Month number (1--12).
   */
-  uint8_t month() const { return m; }
+  constexpr uint8_t month() const { return m; }
   /*!
       @brief  Return the day of the month.
       @return Day of the month (1--31).
   */
-  uint8_t day() const { return d; }
+  constexpr uint8_t day() const { return d; }
   /*!
       @brief  Return the hour
       @return Hour (0--23).
   */
-  uint8_t hour() const { return hh; }
+  constexpr uint8_t hour() const { return hh; }
 
   uint8_t twelveHour() const;
   /*!
       @brief  Return whether the time is PM.
       @return 0 if the time is AM, 1 if it's PM.
   */
-  uint8_t isPM() const { return hh >= 12; }
+  constexpr uint8_t isPM() const { return hh >= 12; }
   /*!
       @brief  Return the minute.
       @return Minute (0--59).
   */
-  uint8_t minute() const { return mm; }
+  constexpr uint8_t minute() const { return mm; }
   /*!
       @brief  Return the second.
       @return Second (0--59).
   */
-  uint8_t second() const { return ss; }
+  constexpr uint8_t second() const { return ss; }
 
-  uint8_t dayOfTheWeek() const;
+  /*!
+      @brief  Return the day of the week.
+      @return Day of week as an integer from 0 (Sunday) to 6 (Saturday).
+  */
+  constexpr uint8_t dayOfTheWeek() const {
+    return (date2days(yOff, m, d) + 6) % 7; // Jan 1, 2000 is a Saturday
+  }
 
-  /* 32-bit times as seconds since 2000-01-01. */
-  uint32_t secondstime() const;
+  /*!
+      @brief  Convert the DateTime to seconds since 1 Jan 2000
+      The result can be converted back to a DateTime with:
+      ```cpp
+      DateTime(SECONDS_FROM_1970_TO_2000 + value)
+      ```
+      @return Number of seconds since 2000-01-01 00:00:00.
+  */
+  constexpr uint32_t secondstime() const {
+    return time2ulong(date2days(yOff, m, d), hh, mm, ss);
+  }
 
-  /* 32-bit times as seconds since 1970-01-01. */
-  uint32_t unixtime(void) const;
+  /*!
+      @brief  Return Unix time: seconds since 1 Jan 1970.
+      @see The `DateTime::DateTime(uint32_t)` constructor is the converse of
+          this method.
+      @return Number of seconds since 1970-01-01 00:00:00.
+  */
+  constexpr uint32_t unixtime(void) const {
+    return secondstime() + SECONDS_FROM_1970_TO_2000;
+  }
+
+  /*!
+      @brief  Given a date, return number of days since 2000/01/01,
+              valid for 2000--2099
+      @param y Year, full or as offset from 2000
+      @param m Month
+      @param d Day
+      @return Number of days
+  */
+  static constexpr uint16_t date2days(uint16_t y, uint8_t m, uint8_t d) {
+    return y >= 2000U ? date2days(y - 2000U, m, d)
+                      : d + days_before_month(m) + (m > 2 && y % 4 == 0) +
+                            365 * y + (y + 3) / 4 - 1;
+  }
 
   /*!
       Format of the ISO 8601 timestamp generated by `timestamp()`. Each
@@ -95,7 +196,16 @@ public:
     TIMESTAMP_TIME, //!< `hh:mm:ss`
     TIMESTAMP_DATE  //!< `YYYY-MM-DD`
   };
+#ifdef PCF85263_NO_HEAP
+  String timestamp(timestampOpt opt = TIMESTAMP_FULL) const = delete;
+#else
   String timestamp(timestampOpt opt = TIMESTAMP_FULL) const;
+#endif
+  char *timestamp(char *buffer, size_t len,
+                  timestampOpt opt = TIMESTAMP_FULL) const;
+
+  void tick();
+  void advance(uint32_t seconds);
 
   DateTime operator+(const TimeSpan &span) const;
   DateTime operator-(const TimeSpan &span) const;
@@ -140,6 +250,93 @@ public:
   bool operator!=(const DateTime &right) const { return !(*this == right); }
 
 protected:
+  /*! Selects the constructor behind the ISO 8601 one. As its first
+      parameter, it keeps `DateTime(0, 1, 1)` on the year/month/day one. */
+  struct IsoTag {};
+  /*!
+      @brief  Constructor behind the ISO 8601 one, with the string length
+      @param iso ISO 8601 string
+      @param len Length of _iso_, at most 19
+  */
+  constexpr DateTime(IsoTag, const char *iso, uint8_t len)
+      : yOff(conv2d(iso_char(iso, len, 2), iso_char(iso, len, 3))),
+        m(conv2d(iso_char(iso, len, 5), iso_char(iso, len, 6))),
+        d(conv2d(iso_char(iso, len, 8), iso_char(iso, len, 9))),
+        hh(conv2d(iso_char(iso, len, 11), iso_char(iso, len, 12))),
+        mm(conv2d(iso_char(iso, len, 14), iso_char(iso, len, 15))),
+        ss(conv2d(iso_char(iso, len, 17), iso_char(iso, len, 18))) {}
+
+  /*!
+      @brief  Days in the year before the first of a month, non-leap year
+      @param m Month 1-12
+      @return Number of days, 0 for invalid months
+  */
+  static constexpr uint16_t days_before_month(uint8_t m) {
+    return (m < 1 || m > 12) ? 0
+           : m <= 2          ? 31 * (m - 1)
+                             : (153U * (m - 3) + 2U) / 5U + 59U;
+  }
+  /*!
+      @brief  Given a number of days, hours, minutes, and seconds, return
+              the total seconds
+      @param days Days
+      @param h Hours
+      @param m Minutes
+      @param s Seconds
+      @return Number of seconds total
+  */
+  static constexpr uint32_t time2ulong(uint16_t days, uint8_t h, uint8_t m, uint8_t s) {
+    return ((days * 24UL + h) * 60 + m) * 60 + s;
+  }
+  /*!
+      @brief  Convert two digits to uint8_t, e.g. '0', '9' returns 9. A
+              leading space or other non-digit counts as 0.
+      @param tens Tens digit
+      @param ones Ones digit
+      @return Value
+  */
+  static constexpr uint8_t conv2d(char tens, char ones) {
+    return 10 * (('0' <= tens && tens <= '9') ? tens - '0' : 0) + ones - '0';
+  }
+  /*!
+      @brief  Month of a `__DATE__` string
+      @param date Date string, e.g. "Apr 16 2020"
+      @return Month 1-12, 0 if not recognised
+  */
+  static constexpr uint8_t month_from_name(const char *date) {
+    // Jan Feb Mar Apr May Jun Jul Aug Sep Oct Nov Dec
+    return date[0] == 'J' ? (date[1] == 'a' ? 1 : (date[2] == 'n' ? 6 : 7))
+         : date[0] == 'F' ? 2
+         : date[0] == 'A' ? (date[2] == 'r' ? 4 : 8)
+         : date[0] == 'M' ? (date[2] == 'r' ? 3 : 5)
+         : date[0] == 'S' ? 9
+         : date[0] == 'O' ? 10
+         : date[0] == 'N' ? 11
+         : date[0] == 'D' ? 12
+                          : 0;
+  }
+  /*!
+      @brief  Length of an ISO 8601 string, capped at 19 characters
+      @param iso ISO 8601 string
+      @param n Characters counted so far
+      @return Length
+  */
+  static constexpr uint8_t iso_length(const char *iso, uint8_t n) {
+    return (n < 19 && iso[n]) ? iso_length(iso, n + 1) : n;
+  }
+  /*!
+      @brief  Character of an ISO 8601 string, or of "2000-01-01T00:00:00"
+              past its end
+      @param iso ISO 8601 string
+      @param len Length from `iso_length()`
+      @param i Index 0-18
+      @return Character
+  */
+  static constexpr char iso_char(const char *iso, uint8_t len, uint8_t i) {
+    return i < len ? iso[i] : "2000-01-01T00:00:00"[i];
+  }
+  void next_day();
+
   uint8_t yOff; ///< Year offset from 2000
   uint8_t m;    ///< Month 1-12
   uint8_t d;    ///< Day 1-31
@@ -148,6 +345,86 @@ protected:
   uint8_t ss;   ///< Seconds 0-59
 };
 
+#define PCF85263_FORMAT_MAX_LEN     40      //< Size of a compiled DateTimeFormat program
+
+/**************************************************************************/
+/*!
+    @brief  A `toString()` format string parsed once into a compact program.
+    The specifiers are the same as for `DateTime::toString(char *)`. They
+    are recognised left to right when the format is compiled, so formatting
+    a DateTime afterwards is a single linear pass without any searching.
+    ```
+    static const DateTimeFormat fmt("DDD, DD MMM YYYY hh:mm:ss");
+    char buffer[32];
+    Serial.println(now.toString(buffer, sizeof(buffer), fmt));
+    ```
+    @note Formats whose program exceeds PCF85263_FORMAT_MAX_LEN bytes are
+        truncated. Each specifier takes two bytes, other characters one.
+*/
+/**************************************************************************/
+class DateTimeFormat {
+public:
+  DateTimeFormat(const char *format);
+
+  /*!
+      @brief  Length of the formatted output, without the terminating NUL.
+      @return Number of characters `DateTime::toString()` will produce.
+  */
+  size_t length() const { return _outLen; }
+
+  /*! Specifiers of a compiled format, stored after a NUL escape byte. */
+  enum token {
+    TOKEN_YYYY = 1, //!< 4-digit year
+    TOKEN_YY,       //!< 2-digit year
+    TOKEN_MMM,      //!< abbreviated month name
+    TOKEN_MM,       //!< 2-digit month
+    TOKEN_DDD,      //!< abbreviated day of the week
+    TOKEN_DD,       //!< 2-digit day
+    TOKEN_hh,       //!< 2-digit hour
+    TOKEN_mm,       //!< 2-digit minute
+    TOKEN_ss,       //!< 2-digit second
+    TOKEN_AP,       //!< "AM" or "PM"
+    TOKEN_ap        //!< "am" or "pm"
+  };
+
+protected:
+  friend class DateTime;
+  uint8_t _program[PCF85263_FORMAT_MAX_LEN]; ///< Literals, and NUL + token
+  uint8_t _size;                             ///< Bytes used in _program
+  uint8_t _outLen;                           ///< Length of the output
+  bool _twelveHour;                          ///< "AP" or "ap" present
+};
+
+/**************************************************************************/
+/*!
+    @brief  DateTime extended by the hundredths of a second counted by the
+            PCF85263 in register 0x00.
+*/
+/**************************************************************************/
+class DateTimeMs : public DateTime {
+public:
+  /*!
+      @brief  Constructor from a DateTime and a hundredths count.
+      @param dt Date and time with seconds resolution.
+      @param hundredths Hundredths of a second (0--99).
+  */
+  DateTimeMs(const DateTime &dt = DateTime(), uint8_t hundredths = 0)
+      : DateTime(dt), cs(hundredths) {}
+  /*!
+      @brief  Return the hundredths of a second.
+      @return Hundredths (0--99).
+  */
+  uint8_t hundredth() const { return cs; }
+  /*!
+      @brief  Return the milliseconds, with 10 ms resolution.
+      @return Milliseconds (0--990).
+  */
+  uint16_t millisecond() const { return cs * 10U; }
+
+protected:
+  uint8_t cs; ///< Hundredths of a second 0-99
+};
+
 /**************************************************************************/
 /*!
     @brief  Timespan which can represent changes in time with seconds accuracy.
@@ -198,6 +475,382 @@ protected:
   int32_t _seconds; ///< Actual TimeSpan value is stored as seconds
 };
 
+/**************************************************************************/
+/*!
+    @brief  Signed time span in hundredths of a second with 64-bit range,
+    for uptimes, stopwatch readings and drift statistics that overflow or
+    get quantized in a TimeSpan. Only the tick count is stored, so adding
+    and subtracting are plain integer operations; the days()..hundredths()
+    accessors divide only when they are called.
+*/
+/**************************************************************************/
+class TimeSpan64 {
+public:
+  /*!
+      @brief  Constructor from hundredths of a second
+      @param centiseconds Span in 1/100 s
+  */
+  constexpr explicit TimeSpan64(int64_t centiseconds = 0) : _ticks(centiseconds) {}
+  /*!
+      @brief  Constructor from a TimeSpan
+      @param span Span with 1 s resolution
+  */
+  TimeSpan64(const TimeSpan &span) : _ticks((int64_t)span.totalseconds() * 100) {}
+  /*!
+      @brief  Span of a number of seconds
+      @param seconds Seconds
+      @return TimeSpan64
+  */
+  static constexpr TimeSpan64 fromSeconds(int64_t seconds) { return TimeSpan64(seconds * 100); }
+  /*!
+      @brief  Span of a stopwatch reading
+      @param ticks Reading of `PCF85263::readStopwatch()`
+      @return TimeSpan64
+  */
+  static constexpr TimeSpan64 fromStopwatch(StopwatchTicks ticks) { return TimeSpan64((int64_t)ticks); }
+
+  /*!
+      @brief  Total number of hundredths of a second
+      @return Ticks
+  */
+  constexpr int64_t ticks() const { return _ticks; }
+  /*!
+      @brief  Span as stopwatch ticks
+      @return Ticks, 0 for negative spans
+  */
+  constexpr StopwatchTicks toStopwatch() const { return _ticks < 0 ? 0 : (StopwatchTicks)_ticks; }
+  /*!
+      @brief  Total number of whole seconds, truncated towards zero
+      @return Seconds
+  */
+  constexpr int64_t totalseconds() const { return _ticks / 100; }
+  /*!
+      @brief  Number of days in the span
+      @return Days
+  */
+  constexpr int32_t days() const { return _ticks / (100LL * 86400); }
+  /*!
+      @brief  Hours in the span, without the days
+      @return Hours
+  */
+  constexpr int8_t hours() const { return _ticks / (100LL * 3600) % 24; }
+  /*!
+      @brief  Minutes in the span, without days and hours
+      @return Minutes
+  */
+  constexpr int8_t minutes() const { return _ticks / (100LL * 60) % 60; }
+  /*!
+      @brief  Seconds in the span, without days, hours and minutes
+      @return Seconds
+  */
+  constexpr int8_t seconds() const { return _ticks / 100 % 60; }
+  /*!
+      @brief  Hundredths in the span, without the whole seconds
+      @return Hundredths
+  */
+  constexpr int8_t hundredths() const { return _ticks % 100; }
+  /*!
+      @brief  Convert to a TimeSpan, truncating the hundredths
+      @return TimeSpan, only meaningful within its 32-bit range
+  */
+  TimeSpan toTimeSpan() const { return TimeSpan((int32_t)totalseconds()); }
+
+  /*! @brief Sum @param right Span to add @return Sum of both spans */
+  constexpr TimeSpan64 operator+(const TimeSpan64 &right) const { return TimeSpan64(_ticks + right._ticks); }
+  /*! @brief Difference @param right Span to subtract @return Difference */
+  constexpr TimeSpan64 operator-(const TimeSpan64 &right) const { return TimeSpan64(_ticks - right._ticks); }
+  /*! @brief Negation @return Span with the opposite sign */
+  constexpr TimeSpan64 operator-() const { return TimeSpan64(-_ticks); }
+  /*! @brief Add in place @param right Span to add @return This span */
+  TimeSpan64 &operator+=(const TimeSpan64 &right) { _ticks += right._ticks; return *this; }
+  /*! @brief Subtract in place @param right Span to subtract @return This span */
+  TimeSpan64 &operator-=(const TimeSpan64 &right) { _ticks -= right._ticks; return *this; }
+  /*! @brief Equality @param right Comparison object @return True if equal */
+  constexpr bool operator==(const TimeSpan64 &right) const { return _ticks == right._ticks; }
+  /*! @brief Inequality @param right Comparison object @return True if not equal */
+  constexpr bool operator!=(const TimeSpan64 &right) const { return _ticks != right._ticks; }
+  /*! @brief Ordering @param right Comparison object @return True if shorter */
+  constexpr bool operator<(const TimeSpan64 &right) const { return _ticks < right._ticks; }
+  /*! @brief Ordering @param right Comparison object @return True if longer */
+  constexpr bool operator>(const TimeSpan64 &right) const { return _ticks > right._ticks; }
+  /*! @brief Ordering @param right Comparison object @return True if not longer */
+  constexpr bool operator<=(const TimeSpan64 &right) const { return _ticks <= right._ticks; }
+  /*! @brief Ordering @param right Comparison object @return True if not shorter */
+  constexpr bool operator>=(const TimeSpan64 &right) const { return _ticks >= right._ticks; }
+
+protected:
+  int64_t _ticks; ///< Span in hundredths of a second
+};
+
+/*!
+    @brief  Time between two precise readings
+    @param left Later time
+    @param right Earlier time
+    @return Signed span in hundredths of a second
+*/
+inline TimeSpan64 operator-(const DateTimeMs &left, const DateTimeMs &right) {
+  return TimeSpan64(((int64_t)left.secondstime() - (int64_t)right.secondstime()) * 100 +
+                    ((int16_t)left.hundredth() - (int16_t)right.hundredth()));
+}
+
+/*!
+    @brief  Precise time shifted by a span
+    @param dt Start time
+    @param span Span to add, the result must stay within 2000--2099
+    @return Shifted time
+*/
+inline DateTimeMs operator+(const DateTimeMs &dt, const TimeSpan64 &span) {
+  int64_t cs = (int64_t)dt.secondstime() * 100 + dt.hundredth() + span.ticks();
+  return DateTimeMs(DateTime((uint32_t)(cs / 100) + SECONDS_FROM_1970_TO_2000), cs % 100);
+}
+
+/*!
+    @brief  Precise time shifted back by a span
+    @param dt Start time
+    @param span Span to subtract, the result must stay within 2000--2099
+    @return Shifted time
+*/
+inline DateTimeMs operator-(const DateTimeMs &dt, const TimeSpan64 &span) {
+  return dt + (-span);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Compact DateTime stored as one 32-bit count of seconds since
+            2000-01-01 00:00:00. Ordering, equality and hashing work on that
+            integer directly; the calendar fields are only computed when
+            converting back to a DateTime.
+    @note   The six DateTime fields need 33 bits when packed as bit fields,
+            so the seconds count is the only 32-bit form that also orders
+            correctly as a plain integer.
+    @note   The calendar fields are deliberately not cached: a cache would
+            double the size of the type and make copies, comparisons and
+            hashing depend on more than the seconds count. To read several
+            fields, call `toDateTime()` once and use the result.
+*/
+/**************************************************************************/
+class PackedDateTime {
+public:
+  /*!
+      @brief  Constructor from seconds since 2000-01-01 00:00:00.
+      @param seconds Seconds since 2000-01-01 00:00:00.
+  */
+  explicit PackedDateTime(uint32_t seconds = 0) : _seconds(seconds) {}
+  /*!
+      @brief  Constructor from a DateTime.
+      @param dt DateTime to pack, should be valid.
+  */
+  PackedDateTime(const DateTime &dt) : _seconds(dt.secondstime()) {}
+
+  /*!
+      @brief  Unpack into a DateTime.
+      @return DateTime holding the same time.
+  */
+  DateTime toDateTime() const {
+    return DateTime(_seconds + SECONDS_FROM_1970_TO_2000);
+  }
+  /*!
+      @brief  Seconds since 2000-01-01 00:00:00, i.e. the packed value.
+      @return Number of seconds.
+  */
+  uint32_t secondstime() const { return _seconds; }
+  /*!
+      @brief  Seconds since 1970-01-01 00:00:00.
+      @return Number of seconds.
+  */
+  uint32_t unixtime() const { return _seconds + SECONDS_FROM_1970_TO_2000; }
+  /*!
+      @brief  Hash value for hash tables and deduplication.
+      @return The packed value itself, which is unique per second.
+  */
+  uint32_t hash() const { return _seconds; }
+
+  /*!
+      @brief  Difference between two packed times.
+      @param right The time to subtract.
+      @return TimeSpan from right to this.
+  */
+  TimeSpan operator-(const PackedDateTime &right) const {
+    return TimeSpan((int32_t)(_seconds - right._seconds));
+  }
+  /*!
+      @brief  Add a TimeSpan.
+      @param span TimeSpan to add.
+      @return Packed time span later than this one.
+  */
+  PackedDateTime operator+(const TimeSpan &span) const {
+    return PackedDateTime(_seconds + span.totalseconds());
+  }
+
+  /*!
+      @brief  Test if this time is earlier than another.
+      @param right Comparison object.
+      @return True if this time is earlier, false otherwise.
+  */
+  bool operator<(const PackedDateTime &right) const {
+    return _seconds < right._seconds;
+  }
+  /*!
+      @brief  Test if this time is later than another.
+      @param right Comparison object.
+      @return True if this time is later, false otherwise.
+  */
+  bool operator>(const PackedDateTime &right) const {
+    return _seconds > right._seconds;
+  }
+  /*!
+      @brief  Test if this time is earlier than or equal to another.
+      @param right Comparison object.
+      @return True if this time is earlier or equal, false otherwise.
+  */
+  bool operator<=(const PackedDateTime &right) const {
+    return _seconds <= right._seconds;
+  }
+  /*!
+      @brief  Test if this time is later than or equal to another.
+      @param right Comparison object.
+      @return True if this time is later or equal, false otherwise.
+  */
+  bool operator>=(const PackedDateTime &right) const {
+    return _seconds >= right._seconds;
+  }
+  /*!
+      @brief  Test if two packed times are equal.
+      @param right Comparison object.
+      @return True if both hold the same second, false otherwise.
+  */
+  bool operator==(const PackedDateTime &right) const {
+    return _seconds == right._seconds;
+  }
+  /*!
+      @brief  Test if two packed times differ.
+      @param right Comparison object.
+      @return True if they hold different seconds, false otherwise.
+  */
+  bool operator!=(const PackedDateTime &right) const {
+    return _seconds != right._seconds;
+  }
+
+protected:
+  uint32_t _seconds; ///< Seconds since 2000-01-01 00:00:00
+};
+
+
+/* Status of an asynchronous transfer */
+#define PCF85263_XFER_DONE          0       //< Transfer finished successfully
+#define PCF85263_XFER_BUSY          1       //< Transfer still in progress
+#define PCF85263_XFER_ERROR         2       //< Transfer failed
+
+#define PCF85263_ERR_NONE           0       //< Transfer succeeded
+#define PCF85263_ERR_OVERFLOW       1       //< Data did not fit the bus driver's buffer
+#define PCF85263_ERR_NACK_ADDR      2       //< Address not acknowledged, device missing
+#define PCF85263_ERR_NACK_DATA      3       //< Data byte not acknowledged
+#define PCF85263_ERR_BUS            4       //< Other bus error, e.g. arbitration lost
+#define PCF85263_ERR_TIMEOUT        5       //< Bus timeout, e.g. clock stretched too long
+#define PCF85263_ERR_SHORT          6       //< Fewer bytes transferred than requested
+#define PCF85263_ERR_UNKNOWN        0xFF    //< Failed, the transport has no details
+
+/**************************************************************************/
+/*!
+    @brief  Bus interface of the RTC. Implementations move raw bytes to and
+            from one device; RTC_I2C builds the register protocol on top.
+            Besides the blocking calls, a transport may implement
+            `start_read()` and `poll()` to run a register read in the
+            background, e.g. by interrupt or DMA. The default
+            implementation completes the read before returning.
+*/
+/**************************************************************************/
+class PCF85263_Transport {
+public:
+  /*!
+      @brief  Initialise the bus and check that the device answers.
+      @return True if the device acknowledged, false otherwise.
+  */
+  virtual bool begin(void) = 0;
+  /*!
+      @brief  Write bytes in one transaction.
+      @param buffer Bytes to write, the register address first
+      @param len Number of bytes
+      @return True if all bytes were acknowledged, false otherwise.
+  */
+  virtual bool write(const uint8_t *buffer, size_t len) = 0;
+  /*!
+      @brief  Write bytes, then read bytes after a repeated start.
+      @param write_buffer Bytes to write, usually the register address
+      @param write_len Number of bytes to write
+      @param read_buffer Buffer receiving the bytes read
+      @param read_len Number of bytes to read
+      @return True if the transfer succeeded, false otherwise.
+  */
+  virtual bool write_then_read(const uint8_t *write_buffer, size_t write_len,
+                               uint8_t *read_buffer, size_t read_len) = 0;
+  virtual bool start_read(uint8_t reg, uint8_t *read_buffer, size_t read_len);
+  virtual uint8_t poll(void);
+  /*!
+      @brief  Reason for the failure of the last transfer
+      @return PCF85263_ERR_*, PCF85263_ERR_NONE if it succeeded
+  */
+  uint8_t last_error(void) const { return error; }
+
+protected:
+  ~PCF85263_Transport() {}
+  uint8_t async_status = PCF85263_XFER_DONE; ///< Status of the last start_read()
+  uint8_t error = PCF85263_ERR_NONE;         ///< Result of the last transfer
+};
+
+/*!
+    @brief  Bus statistics of one API group, see `PCF85263::getStats()`
+*/
+struct PCF85263_Stats {
+  uint32_t transactions;  ///< Transfers started
+  uint32_t bytes;         ///< Bytes written and read, register addresses included
+  uint32_t micros;        ///< Time spent in the transport
+  uint16_t errors;        ///< Failed transfers
+  uint8_t last_error;     ///< PCF85263_ERR_* of the last failed transfer
+};
+
+/* API groups the statistics are kept for. The counting is compiled in only
+   when the library is built with -DPCF85263_ENABLE_STATS; otherwise the
+   counters stay 0. The class layout does not depend on it. */
+#define PCF85263_API_OTHER          0       //< Calls outside the groups below
+#define PCF85263_API_BEGIN          1       //< begin(), syncCache()
+#define PCF85263_API_CONFIGURE      2       //< configure(), commit()
+#define PCF85263_API_START_STOP     3       //< start(), stop()
+#define PCF85263_API_ADJUST         4       //< adjust()
+#define PCF85263_API_NOW            5       //< now(), requestNow(), readRawTime()
+#define PCF85263_API_NOW_PRECISE    6       //< nowPrecise()
+#define PCF85263_API_ASYNC          7       //< requestRead(), poll(), readRaw()
+#define PCF85263_API_STOPWATCH      8       //< Stopwatch and hundredths
+#define PCF85263_API_ALARM          9       //< Alarm setters and getters
+#define PCF85263_API_FLAGS          10      //< getFlags(), clearFlags(), serviceInterrupt()
+#define PCF85263_API_RAM            11      //< readRam(), writeRam(), registerBoot()
+#define PCF85263_API_TIMESTAMP      12      //< Timestamp registers and modes
+#define PCF85263_API_INTERRUPT      13      //< setINTA(), setINTB(), setInterrupts()
+#define PCF85263_API_OSCILLATOR     14      //< Offset, jitter and load caps
+#define PCF85263_API_WATCHDOG       15      //< configureWatchdog(), kick()
+#define PCF85263_API_SECOND_TICK    16      //< Software clock on INTA
+#define PCF85263_API_POWER          17      //< Battery switch, clock output, periodic interrupt, STOP source
+#define PCF85263_API_COUNT          18      //< Number of API groups
+
+#ifdef PCF85263_ENABLE_STATS
+/*!
+    @brief  Charges the bus traffic of its lifetime to an API group. Nested
+            scopes keep the outermost group, so helpers called by an API
+            function are charged to that function.
+*/
+class PCF85263_StatsScope {
+public:
+  PCF85263_StatsScope(class RTC_I2C &owner, uint8_t api);
+  ~PCF85263_StatsScope();
+
+private:
+  class RTC_I2C &owner;   ///< Device being measured
+  uint8_t previous;       ///< Group active before this scope
+};
+#define PCF85263_STATS_SCOPE(api) PCF85263_StatsScope pcf85263_stats_scope(*this, api)
+#else
+#define PCF85263_STATS_SCOPE(api)
+#endif
 
 /**************************************************************************/
 /*!
@@ -205,6 +858,7 @@ protected:
 */
 /**************************************************************************/
 class RTC_I2C {
+  friend class PCF85263_StatsScope;
 protected:
   /*!
       @brief  Convert a binary coded decimal value to binary. RTC stores time/date values as BCD.
@@ -218,9 +872,37 @@ protected:
       @return BCD value
   */
   static uint8_t bin2bcd(uint8_t val) { return val + 6 * (val / 10); }
-  Adafruit_I2CDevice *i2c_dev = NULL; ///< Pointer to I2C bus interface
+  PCF85263_Transport *transport = NULL; ///< Pointer to I2C bus interface
   uint8_t read_register(uint8_t reg);
   void write_register(uint8_t reg, uint8_t val);
+
+#ifdef PCF85263_ENABLE_STATS
+  bool bus_write(const uint8_t *buffer, size_t len);
+  bool bus_write_then_read(const uint8_t *write_buffer, size_t write_len,
+                           uint8_t *read_buffer, size_t read_len);
+  bool bus_start_read(uint8_t reg, uint8_t *read_buffer, size_t read_len);
+  void record_stats(size_t len, uint32_t start, bool ok);
+  void record_error(void);
+#else
+  /*! @brief Forward to transport->write() without statistics */
+  bool bus_write(const uint8_t *buffer, size_t len) {
+    return transport->write(buffer, len);
+  }
+  /*! @brief Forward to transport->write_then_read() without statistics */
+  bool bus_write_then_read(const uint8_t *write_buffer, size_t write_len,
+                           uint8_t *read_buffer, size_t read_len) {
+    return transport->write_then_read(write_buffer, write_len, read_buffer, read_len);
+  }
+  /*! @brief Forward to transport->start_read() without statistics */
+  bool bus_start_read(uint8_t reg, uint8_t *read_buffer, size_t read_len) {
+    return transport->start_read(reg, read_buffer, read_len);
+  }
+  /*! @brief Failed background transfer, nothing to record */
+  void record_error(void) {}
+#endif
+
+  PCF85263_Stats stats[PCF85263_API_COUNT] = {}; ///< Bus statistics per API group
+  uint8_t stats_api = PCF85263_API_OTHER;         ///< Group charged for transfers
 };
 
 
@@ -239,6 +921,15 @@ protected:
 #define PCF85263_MONTH              0x06    //< PCF85263-Register months
 #define PCF85263_YEAR               0x07    //< PCF85263-Register years
 
+/* Stopwatch - Registers, replace DAY..YEAR in stopwatch mode */
+#define PCF85263_SW_HOURS_XX_XX_00  0x03    //< PCF85263-Register stopwatch hours, digits 1 and 2
+#define PCF85263_SW_HOURS_XX_00_XX  0x04    //< PCF85263-Register stopwatch hours, digits 3 and 4
+#define PCF85263_SW_HOURS_00_XX_XX  0x05    //< PCF85263-Register stopwatch hours, digits 5 and 6
+#define PCF85263_SW_HOURS_MAX       999999UL //< Largest hour count of the stopwatch
+#define PCF85263_RAW_TIME_LEN       7       //< Bytes of a raw time snapshot, SECOND..YEAR
+#define PCF85263_RAW_TIME_FULL_LEN  8       //< Bytes of a RawTime, 100TH_SECONDS..YEAR
+#define PCF85263_ROLLOVER_GUARD     98      //< Hundredths from which a consistent read checks for a rollover
+
 /* Alarm1 Time - Registers */
 #define PCF85263_ALM1_SECONDS       0x08    //< PCF85263-Register Alarm1 seconds
 #define PCF85263_ALM1_MINUTE        0x09    //< PCF85263-Register Alarm1 minutes
@@ -247,12 +938,24 @@ protected:
 #define PCF85263_ALM1_MONTH         0x0C    //< PCF85263-Register Alarm1 months
 
 /* Alarm2 Time - Registers */
-#define PCF85263_ALM2_SECONDS       0x0D    //< PCF85263-Register Alarm2 seconds
-#define PCF85263_ALM2_MINUTE        0x0E    //< PCF85263-Register Alarm2 minutes
+#define PCF85263_ALM2_MINUTE        0x0D    //< PCF85263-Register Alarm2 minutes
+#define PCF85263_ALM2_HOUR          0x0E    //< PCF85263-Register Alarm2 hours
 #define PCF85263_ALM2_WEEKDAY       0x0F    //< PCF85263-Register Alarm2 weekday
+/* Deprecated: Alarm2 has no seconds register, 0x0D holds its minutes */
+#define PCF85263_ALM2_SECONDS       PCF85263_ALM2_MINUTE    //< Deprecated, use PCF85263_ALM2_MINUTE
 
 /* Alarm Enable - Register */
 #define PCF85263_ALMEN              0x10    //< PCF85263-Register Alarm Enable
+#define PCF85263_ALMEN_ALARM1       0x1F    //< ALMEN bits of Alarm1: second, minute, hour, day, month
+#define PCF85263_ALMEN_ALARM2       0xE0    //< ALMEN bits of Alarm2: minute, hour, weekday
+
+/* Alarm fields, combined into the mask of an AlarmSpec */
+#define PCF85263_ALARM_SECOND       0x01    //< Match the second (Alarm1 only)
+#define PCF85263_ALARM_MINUTE       0x02    //< Match the minute
+#define PCF85263_ALARM_HOUR         0x04    //< Match the hour
+#define PCF85263_ALARM_DAY          0x08    //< Match the day of the month (Alarm1 only)
+#define PCF85263_ALARM_MONTH        0x10    //< Match the month (Alarm1 only)
+#define PCF85263_ALARM_WEEKDAY      0x20    //< Match the day of the week (Alarm2 only)
 
 /* Timestamp 1 - Registers */
 #define PCF85263_TSTMP1_SECONDS     0x11    //< PCF85263-Register Timestamp1 seconds
@@ -281,6 +984,9 @@ protected:
 /* Timestamp Control - Register */
 #define PCF85263_TSTMP_Control      0x23    //< PCF85263-Register Timestamp Control
 
+/* Timestamp Control - Register fields */
+#define PCF85263_TSTMP_BURST_LEN    19      //< TSTMP1_SECONDS..TSTMP_Control
+
 /* Offset-Mode - Register */
 #define PCF85263_OFFSETMODE_NORMAL    0    //< PCF85263-OFFSETMODE
 #define PCF85263_OFFSETMODE_FAST      1    //< PCF85263-OFFSETMODE
@@ -304,23 +1010,536 @@ protected:
 #define PCF85263_STOPEN             0x2E    //< PCF85263-Register STOP Enable
 #define PCF85263_RESETS             0x2F    //< PCF85263-Register Resets
 
+/* Watchdog - Register */
+#define PCF85263_WD_REPEAT          0x80    //< WDM, raise the interrupt on every expiry
+#define PCF85263_WD_PERIOD_MAX      31      //< Largest WDR value, in steps
+
+/* Flags - Register */
+#define PCF85263_FLAG_PERIODIC      0x80    //< PIF, periodic interrupt
+#define PCF85263_FLAG_ALARM2        0x40    //< A2F, Alarm2
+#define PCF85263_FLAG_ALARM1        0x20    //< A1F, Alarm1
+#define PCF85263_FLAG_WATCHDOG      0x10    //< WDF, watchdog
+#define PCF85263_FLAG_BATTERY       0x08    //< BSF, battery switch-over
+#define PCF85263_FLAG_TSR3          0x04    //< TSR3F, timestamp register 3
+#define PCF85263_FLAG_TSR2          0x02    //< TSR2F, timestamp register 2
+#define PCF85263_FLAG_TSR1          0x01    //< TSR1F, timestamp register 1
+#define PCF85263_FLAG_TIMESTAMPS    0x07    //< TSR1F..TSR3F
+#define PCF85263_FLAG_COUNT         8       //< Number of flags
+#define PCF85263_INT_BURST_LEN      27      //< TSTMP1_SECONDS..FLAGS, read by serviceInterrupt() for timestamps
+
+/* Shadow register cache */
+#define PCF85263_SHADOW_SIZE        13      //< ALMEN plus the control block TSTMP_Control..STOPEN
+#define PCF85263_CTRL_BURST_LEN     12      //< Length of the control block burst TSTMP_Control..STOPEN
+#define PCF85263_BURST_MAX_GAP      3       //< Clean registers a commit() burst may rewrite to avoid a new transfer
+
 /*=============================================================================================*/
 
+#define PCF85263_REGISTER_COUNT     0x30    //< Number of registers, the address wraps after RESETS
+#define PCF85263_HAL_TIMEOUT_MS     10      //< Timeout of blocking HAL transfers
+#ifndef PCF85263_WIRE_MAX_READ
+#ifdef BUFFER_LENGTH
+#define PCF85263_WIRE_MAX_READ      BUFFER_LENGTH //< Largest single requestFrom() of PCF85263_WireTransport
+#else
+#define PCF85263_WIRE_MAX_READ      32      //< Largest single requestFrom() of PCF85263_WireTransport
+#endif
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  Transport straight on a TwoWire bus, without the BusIO layer
+            and without any heap allocation. This is the transport used by
+            `PCF85263::begin(TwoWire *)`.
+*/
+/**************************************************************************/
+class PCF85263_WireTransport : public PCF85263_Transport {
+public:
+  /*!
+      @brief  Constructor
+      @param wire I2C bus
+      @param addr 7-bit I2C address
+  */
+  PCF85263_WireTransport(TwoWire *wire = &Wire, uint8_t addr = PCF85263_ADDRESS)
+      : wire(wire), addr(addr) {}
+  /*!
+      @brief  Select bus and address
+      @param bus I2C bus
+      @param address 7-bit I2C address
+  */
+  void setBus(TwoWire *bus, uint8_t address = PCF85263_ADDRESS) {
+    wire = bus;
+    addr = address;
+  }
+  bool begin(void);
+  bool write(const uint8_t *buffer, size_t len);
+  bool write_then_read(const uint8_t *write_buffer, size_t write_len,
+                       uint8_t *read_buffer, size_t read_len);
+
+protected:
+  TwoWire *wire; ///< I2C bus
+  uint8_t addr;  ///< 7-bit I2C address
+};
+
+/**************************************************************************/
+/*!
+    @brief  Transport on a register array in RAM, for running the driver
+            without a device. Writes and reads auto-increment the register
+            address like the PCF85263 and every transfer is counted.
+*/
+/**************************************************************************/
+class PCF85263_MockTransport : public PCF85263_Transport {
+public:
+  PCF85263_MockTransport() { memset(registers, 0, sizeof(registers)); resetCounters(); }
+  bool begin(void) { return present; }
+  bool write(const uint8_t *buffer, size_t len);
+  bool write_then_read(const uint8_t *write_buffer, size_t write_len,
+                       uint8_t *read_buffer, size_t read_len);
+  /*!
+      @brief  Clear the transfer counters
+  */
+  void resetCounters(void) {
+    transactions = 0;
+    bytes_written = 0;
+    bytes_read = 0;
+  }
 
+  uint8_t registers[PCF85263_REGISTER_COUNT]; ///< Register file of the device
+  bool present = true;     ///< Acknowledge transfers, false simulates a missing device
+  uint32_t transactions;   ///< Transfers started, a write_then_read() counts once
+  uint32_t bytes_written;  ///< Bytes written, register addresses included
+  uint32_t bytes_read;     ///< Bytes read
+
+protected:
+  uint8_t pointer = 0;     ///< Register address of the next access
+};
 
+/**************************************************************************/
+/*!
+    @brief  Transport over an Adafruit_I2CDevice
+*/
+/**************************************************************************/
+class PCF85263_AdafruitTransport : public PCF85263_Transport {
+public:
+  /*!
+      @brief  Constructor
+      @param dev Device to talk through, see `setDevice()`
+  */
+  PCF85263_AdafruitTransport(Adafruit_I2CDevice *dev = NULL) : dev(dev) {}
+  /*!
+      @brief  Select the device to talk through
+      @param device I2C device, owned by the caller
+  */
+  void setDevice(Adafruit_I2CDevice *device) { dev = device; }
+  bool begin(void);
+  bool write(const uint8_t *buffer, size_t len);
+  bool write_then_read(const uint8_t *write_buffer, size_t write_len,
+                       uint8_t *read_buffer, size_t read_len);
+
+protected:
+  Adafruit_I2CDevice *dev; ///< Underlying BusIO device
+};
+
+#if defined(ARDUINO_ARCH_STM32) && defined(HAL_I2C_MODULE_ENABLED)
+/**************************************************************************/
+/*!
+    @brief  Transport using the STM32 HAL directly. Register reads started
+            with `start_read()` run by DMA (or interrupt) while the CPU
+            continues; `poll()` reports completion.
+    @note   The I2C handle, and for DMA mode its DMA stream and IRQ
+            handlers, must be set up by the application. Use an I2C
+            peripheral that is not also driven by a TwoWire instance.
+*/
+/**************************************************************************/
+class PCF85263_HALTransport : public PCF85263_Transport {
+public:
+  /*!
+      @brief  Constructor
+      @param hi2c Initialised HAL I2C handle
+      @param use_dma True to run start_read() by DMA, false by interrupt
+      @param addr 7-bit I2C address
+  */
+  PCF85263_HALTransport(I2C_HandleTypeDef *hi2c, bool use_dma = true,
+                        uint8_t addr = PCF85263_ADDRESS)
+      : hi2c(hi2c), use_dma(use_dma), addr(addr << 1) {}
+  bool begin(void);
+  bool write(const uint8_t *buffer, size_t len);
+  bool write_then_read(const uint8_t *write_buffer, size_t write_len,
+                       uint8_t *read_buffer, size_t read_len);
+  bool start_read(uint8_t reg, uint8_t *read_buffer, size_t read_len);
+  uint8_t poll(void);
+
+protected:
+  bool set_error(HAL_StatusTypeDef status);
+
+  I2C_HandleTypeDef *hi2c; ///< HAL handle of the bus
+  bool use_dma;            ///< DMA or interrupt driven start_read()
+  uint16_t addr;           ///< 8-bit HAL address, i.e. 7-bit address << 1
+};
+#endif
+
+/*!
+    @brief  Completion callback of `PCF85263::requestNow()`
+    @param now Date and time read from the device
+*/
+typedef void (*PCF85263_NowCallback)(const DateTime &now);
+/*!
+    @brief  Completion callback of `PCF85263::requestRead()`
+    @param reg First register read
+    @param data Register contents
+    @param len Number of registers read
+*/
+typedef void (*PCF85263_ReadCallback)(uint8_t reg, const uint8_t *data, size_t len);
+/*!
+    @brief  Callback of `PCF85263::serviceInterrupt()`
+    @param flag PCF85263_FLAG_* bit that was set
+    @param timestamp Content of the matching timestamp register for
+        PCF85263_FLAG_TSR1..TSR3, NULL for all other flags
+*/
+typedef void (*PCF85263_InterruptCallback)(uint8_t flag, const DateTime *timestamp);
+
+
+/*! Interrupt sources of INTA and INTB, bits of INTA_enable / INTB_enable */
+enum IntSource {
+  PCF85263_INT_WATCHDOG = 0x01,   //!< Watchdog
+  PCF85263_INT_BATTERY = 0x02,    //!< Battery switch-over
+  PCF85263_INT_TIMESTAMP = 0x04,  //!< Timestamp
+  PCF85263_INT_ALARM2 = 0x08,     //!< Alarm2
+  PCF85263_INT_ALARM1 = 0x10,     //!< Alarm1
+  PCF85263_INT_OFFSET = 0x20,     //!< Offset correction
+  PCF85263_INT_PERIODIC = 0x40,   //!< Periodic interrupt
+  PCF85263_INT_PULSE = 0x80       //!< Pulse instead of level output, not a source
+};
+
+/**************************************************************************/
+/*!
+    @brief  Set of interrupt sources routed to one pin. Sources are combined
+            with `|`, e.g. `PCF85263_INT_PULSE | PCF85263_INT_ALARM1`, and
+            the result is the register value, so building it costs nothing
+            at run time.
+*/
+/**************************************************************************/
+struct IntSources {
+  uint8_t bits; ///< Value of INTA_enable / INTB_enable
+
+  /*! @brief No source */
+  constexpr IntSources() : bits(0) {}
+  /*!
+      @brief  Single source
+      @param source PCF85263_INT_*
+  */
+  constexpr IntSources(IntSource source) : bits((uint8_t)source) {}
+  /*!
+      @brief  Sources from a raw register value
+      @param value INTA_enable / INTB_enable value
+  */
+  explicit constexpr IntSources(uint8_t value) : bits(value) {}
+
+  /*!
+      @brief  Add sources
+      @param other Sources to add
+      @return Union of both sets
+  */
+  constexpr IntSources operator|(IntSources other) const { return IntSources((uint8_t)(bits | other.bits)); }
+  /*!
+      @brief  Check for sources
+      @param other Sources to look for
+      @return True if all of _other_ are in the set
+  */
+  constexpr bool has(IntSources other) const { return (bits & other.bits) == other.bits; }
+};
+
+/*!
+    @brief  Combine two sources
+    @param a First source
+    @param b Second source
+    @return Set of both sources
+*/
+constexpr IntSources operator|(IntSource a, IntSource b) { return IntSources(a) | IntSources(b); }
+
+/**************************************************************************/
+/*!
+    @brief  Alarm condition with a per-field enable mask. The alarm fires
+            whenever all fields selected in _mask_ match the clock, so
+            leaving fields out gives recurring alarms.
+            Alarm1 compares second, minute, hour, day and month; Alarm2
+            compares minute, hour and weekday. Fields an alarm does not
+            have are ignored.
+*/
+/**************************************************************************/
+struct AlarmSpec {
+  uint8_t second;   ///< Second 0-59
+  uint8_t minute;   ///< Minute 0-59
+  uint8_t hour;     ///< Hour 0-23
+  uint8_t day;      ///< Day of the month 1-31
+  uint8_t month;    ///< Month 1-12
+  uint8_t weekday;  ///< Day of the week, 0 (Sunday) to 6 (Saturday)
+  uint8_t mask;     ///< PCF85263_ALARM_* fields that must match
+
+  /*!
+      @brief  Alarm that never fires
+      @return AlarmSpec with all fields disabled
+  */
+  static AlarmSpec never() { return AlarmSpec{0, 0, 0, 1, 1, 0, 0}; }
+  /*!
+      @brief  Once a minute, e.g. at :30 (Alarm1)
+      @param sec Second of the minute
+      @return AlarmSpec
+  */
+  static AlarmSpec everyMinuteAt(uint8_t sec) {
+    return AlarmSpec{sec, 0, 0, 1, 1, 0, PCF85263_ALARM_SECOND};
+  }
+  /*!
+      @brief  Once an hour
+      @param min Minute of the hour
+      @param sec Second of the minute, only used by Alarm1
+      @return AlarmSpec
+  */
+  static AlarmSpec everyHourAt(uint8_t min, uint8_t sec = 0) {
+    return AlarmSpec{sec, min, 0, 1, 1, 0,
+                     PCF85263_ALARM_SECOND | PCF85263_ALARM_MINUTE};
+  }
+  /*!
+      @brief  Once a day
+      @param h Hour
+      @param min Minute
+      @param sec Second, only used by Alarm1
+      @return AlarmSpec
+  */
+  static AlarmSpec dailyAt(uint8_t h, uint8_t min, uint8_t sec = 0) {
+    return AlarmSpec{sec, min, h, 1, 1, 0,
+                     PCF85263_ALARM_SECOND | PCF85263_ALARM_MINUTE |
+                         PCF85263_ALARM_HOUR};
+  }
+  /*!
+      @brief  Once a week, e.g. every Monday 06:00 (Alarm2)
+      @param wday Day of the week, 0 (Sunday) to 6 (Saturday)
+      @param h Hour
+      @param min Minute
+      @return AlarmSpec
+  */
+  static AlarmSpec weeklyAt(uint8_t wday, uint8_t h, uint8_t min) {
+    return AlarmSpec{0, min, h, 1, 1, wday,
+                     PCF85263_ALARM_MINUTE | PCF85263_ALARM_HOUR |
+                         PCF85263_ALARM_WEEKDAY};
+  }
+  /*!
+      @brief  Once a month (Alarm1)
+      @param mday Day of the month
+      @param h Hour
+      @param min Minute
+      @param sec Second
+      @return AlarmSpec
+  */
+  static AlarmSpec monthlyAt(uint8_t mday, uint8_t h, uint8_t min,
+                             uint8_t sec = 0) {
+    return AlarmSpec{sec, min, h, mday, 1, 0,
+                     PCF85263_ALARM_SECOND | PCF85263_ALARM_MINUTE |
+                         PCF85263_ALARM_HOUR | PCF85263_ALARM_DAY};
+  }
+  /*!
+      @brief  At a given date and time. Alarm1 has no year, so this repeats
+              yearly; Alarm2 uses minute, hour and weekday of _dt_.
+      @param dt Date and time
+      @return AlarmSpec
+  */
+  static AlarmSpec at(const DateTime &dt) {
+    return AlarmSpec{dt.second(), dt.minute(), dt.hour(), dt.day(),
+                     dt.month(), dt.dayOfTheWeek(),
+                     PCF85263_ALARM_SECOND | PCF85263_ALARM_MINUTE |
+                         PCF85263_ALARM_HOUR | PCF85263_ALARM_DAY |
+                         PCF85263_ALARM_MONTH | PCF85263_ALARM_WEEKDAY};
+  }
+};
+
+/**************************************************************************/
+/*!
+    @brief  Undecoded time registers 100TH_SECONDS..YEAR, as read by
+    `PCF85263::readRawTime()`. The accessors decode only the field asked
+    for, so capturing costs a single burst and a copy of eight bytes.
+    `regs + 1` is a snapshot in the layout of `PCF85263::decodeTimes()`.
+*/
+/**************************************************************************/
+struct RawTime {
+  uint8_t regs[PCF85263_RAW_TIME_FULL_LEN]; ///< Registers 0x00..0x07
+
+  /*!
+      @brief  Convert a BCD register value
+      @param val BCD value, already masked
+      @return Binary value
+  */
+  static constexpr uint8_t bcd(uint8_t val) { return val - 6 * (val >> 4); }
+
+  /*! @brief Hundredths of a second @return 0-99 */
+  constexpr uint8_t hundredth() const { return bcd(regs[0]); }
+  /*! @brief Second @return 0-59 */
+  constexpr uint8_t second() const { return bcd(regs[1] & 0x7F); }
+  /*! @brief Minute @return 0-59 */
+  constexpr uint8_t minute() const { return bcd(regs[2] & 0x7F); }
+  /*! @brief Hour @return 0-23 */
+  constexpr uint8_t hour() const { return bcd(regs[3] & 0x3F); }
+  /*! @brief Day of the month @return 1-31 */
+  constexpr uint8_t day() const { return bcd(regs[4] & 0x3F); }
+  /*! @brief Day of the week @return 0 (Sunday) to 6 (Saturday) */
+  constexpr uint8_t weekday() const { return regs[5] & 0x07; }
+  /*! @brief Month @return 1-12 */
+  constexpr uint8_t month() const { return bcd(regs[6] & 0x1F); }
+  /*! @brief Year @return 2000-2099 */
+  constexpr uint16_t year() const { return 2000U + bcd(regs[7]); }
+  /*!
+      @brief  Oscillator stop flag
+      @return True if the clock stopped since the time was set
+  */
+  constexpr bool oscillatorStopped() const { return regs[1] & 0x80; }
+
+  /*!
+      @brief  Decode all fields
+      @return DateTime with the hundredths dropped
+  */
+  DateTime toDateTime() const {
+    return DateTime(year(), month(), day(), hour(), minute(), second());
+  }
+};
+
+/*!
+    @brief  Content of the three timestamp registers and the timestamp mode
+            register, as returned by `PCF85263::readAllTimestamps()`
+*/
+struct PCF85263_Timestamps {
+  DateTime tsr1;  ///< Timestamp register 1, TS pin events
+  DateTime tsr2;  ///< Timestamp register 2, first battery switch-over with configure()
+  DateTime tsr3;  ///< Timestamp register 3, last battery switch-over with configure()
+  uint8_t mode;   ///< Raw content of register Timestamp Control
+};
+
+#define PCF85263_BOOT_COLD          0       //< Oscillator was stopped, the time and the RAM byte are lost
+#define PCF85263_BOOT_BROWNOUT      1       //< VDD dropped and the device ran from the battery
+#define PCF85263_BOOT_WARM          2       //< MCU reset while VDD stayed up
+#define PCF85263_BOOT_BURST_LEN     7       //< FLAGS..SECOND, the address wraps after RESETS
+
+/*!
+    @brief  Result of `PCF85263::registerBoot()`
+*/
+struct PCF85263_BootInfo {
+  uint8_t kind;                 ///< PCF85263_BOOT_COLD, _BROWNOUT or _WARM
+  uint8_t sequence;             ///< Boots since the last cold start, 0 on a cold start, wraps at 255
+  DateTime lastBatterySwitch;   ///< Last switch-over to battery, only read on a brown-out
+};
 
 class PCF85263 : RTC_I2C
 {
 public:
-    bool begin(TwoWire *wireInstance = &Wire);
+    /*! Events recorded by timestamp register 1 */
+    enum TSR1Mode {
+      TSR1_OFF = 0,         //!< No timestamp
+      TSR1_FIRST_TS = 1,    //!< First TS pin event
+      TSR1_LAST_TS = 2      //!< Last TS pin event
+    };
+    /*! Events recorded by timestamp register 2 */
+    enum TSR2Mode {
+      TSR2_OFF = 0,             //!< No timestamp
+      TSR2_FIRST_BATTERY = 1,   //!< First switch-over to battery
+      TSR2_LAST_BATTERY = 2,    //!< Last switch-over to battery
+      TSR2_LAST_VDD = 3,        //!< Last switch-back to VDD
+      TSR2_FIRST_TS = 4,        //!< First TS pin event
+      TSR2_LAST_TS = 5          //!< Last TS pin event
+    };
+    /*! Events recorded by timestamp register 3 */
+    enum TSR3Mode {
+      TSR3_OFF = 0,             //!< No timestamp
+      TSR3_FIRST_BATTERY = 1,   //!< First switch-over to battery
+      TSR3_LAST_BATTERY = 2,    //!< Last switch-over to battery
+      TSR3_LAST_VDD = 3         //!< Last switch-back to VDD
+    };
+    /*! Duration of one watchdog period step */
+    enum WatchdogStep {
+      WD_STEP_4S = 0,           //!< 4 s (1/4 Hz)
+      WD_STEP_1S = 1,           //!< 1 s (1 Hz)
+      WD_STEP_250MS = 2,        //!< 1/4 s (4 Hz)
+      WD_STEP_62MS = 3          //!< 1/16 s (16 Hz)
+    };
+    /*! Interrupt output pin */
+    enum IntPin {
+      INT_A = 0,                //!< INTA
+      INT_B = 1                 //!< INTB
+    };
+    /*! Supply voltage threshold of the battery switch */
+    enum BatterySwitchThreshold {
+      BSW_THRESHOLD_1V5 = 0,    //!< V_th = 1.5 V
+      BSW_THRESHOLD_2V8 = 1     //!< V_th = 2.8 V
+    };
+    /*! Condition for switching from VDD to VBAT */
+    enum BatterySwitchMode {
+      BSW_AT_VTH = 0,           //!< VDD drops below V_th
+      BSW_AT_VBAT = 1,          //!< VDD drops below VBAT
+      BSW_AT_MAX = 2,           //!< VDD drops below the higher of V_th and VBAT
+      BSW_AT_MIN = 3            //!< VDD drops below the lower of V_th and VBAT
+    };
+    /*! Frequency on the CLK pin */
+    enum ClockOut {
+      CLKOUT_32768HZ = 0,       //!< 32768 Hz
+      CLKOUT_16384HZ = 1,       //!< 16384 Hz
+      CLKOUT_8192HZ = 2,        //!< 8192 Hz
+      CLKOUT_4096HZ = 3,        //!< 4096 Hz
+      CLKOUT_2048HZ = 4,        //!< 2048 Hz
+      CLKOUT_1024HZ = 5,        //!< 1024 Hz
+      CLKOUT_1HZ = 6,           //!< 1 Hz
+      CLKOUT_OFF = 7            //!< Static low
+    };
+    /*! Rate of the periodic interrupt */
+    enum PeriodicRate {
+      PERIODIC_OFF = 0,         //!< No periodic interrupt
+      PERIODIC_SECOND = 1,      //!< Once per second
+      PERIODIC_MINUTE = 2,      //!< Once per minute, at second 00
+      PERIODIC_HOUR = 3         //!< Once per hour, at minute 00
+    };
+    /*! What can stop the clock */
+    enum StopSource {
+      STOP_BY_BIT = 0,          //!< The STOP bit only
+      STOP_BY_BIT_OR_TS = 1     //!< The STOP bit or the TS pin
+    };
+
+    bool begin(TwoWire *wireInstance = &Wire, bool useCache = false);
+    bool begin(PCF85263_Transport &bus, bool useCache = false);
+    bool syncCache(void);
+    void invalidateCache(void);
+    void beginTransaction(void);
+    bool commit(void);
     void start(void);
     void stop(void);
     void configure();
     void adjust(const DateTime &dt);
     DateTime now();
+    bool requestNow(PCF85263_NowCallback callback = NULL);
+    bool requestRead(uint8_t reg, uint8_t *buffer, size_t len, PCF85263_ReadCallback callback = NULL);
+    bool readRaw(uint8_t reg, uint8_t *dst, size_t len);
+    bool readRawTime(RawTime &raw);
+    uint8_t poll(void);
+    DateTimeMs nowPrecise();
+    void enableHundredths(bool en);
+    void setConsistentRead(bool en);
+
+    static void decodeTimes(const uint8_t *raw, size_t n, uint32_t *unixtimes);
+    static void encodeTimes(const uint32_t *unixtimes, size_t n, uint8_t *raw);
+
+    void setStopwatchMode(bool stopwatch_mode);
+    bool getStopwatchMode(void);
+    StopwatchTicks readStopwatch();
+    void setStopwatch(StopwatchTicks ticks);
     void setAlarm(const DateTime &dt);
     DateTime getAlarm();
     uint8_t enableAlarm(bool en);
+    void setAlarm1(const AlarmSpec &alarm);
+    void setAlarm2(const AlarmSpec &alarm);
+    void setAlarms(const AlarmSpec &alarm1, const AlarmSpec &alarm2);
+    bool getAlarms(AlarmSpec &alarm1, AlarmSpec &alarm2);
+
+    uint8_t getFlags();
+    void clearFlags(uint8_t mask);
+    void onInterrupt(uint8_t flags, PCF85263_InterruptCallback callback);
+    uint8_t serviceInterrupt(PCF85263_Timestamps *timestamps = NULL);
+
+    uint8_t readRam(void);
+    void writeRam(uint8_t value);
+    PCF85263_BootInfo registerBoot(void);
 
     bool getOffsetMode(void);
     void setOffsetMode(bool offset_mode);
@@ -334,11 +1553,102 @@ public:
 
     DateTime getTimestampFirstBatSw();
     DateTime getTimestampLastBatSw();
+    bool readAllTimestamps(PCF85263_Timestamps &timestamps);
+    void setTimestampModes(TSR1Mode tsr1, TSR2Mode tsr2, TSR3Mode tsr3);
+    TSR1Mode getTSR1Mode(void);
+    TSR2Mode getTSR2Mode(void);
+    TSR3Mode getTSR3Mode(void);
 
     void setINTA(bool pulse_mode, bool periodic_int, bool offset_correc_int, bool alarm1_int, bool alarm2_int,
     bool timestamp_int, bool battery_switch_int, bool watchdog_int);
     void setINTB(bool pulse_mode, bool periodic_int, bool offset_correc_int, bool alarm1_int, bool alarm2_int,
     bool timestamp_int, bool battery_switch_int, bool watchdog_int);
+    void setInterrupts(IntPin pin, IntSources sources);
+    void setInterrupts(IntSources inta, IntSources intb);
+    IntSources getInterrupts(IntPin pin);
+
+    void configureWatchdog(uint8_t period, WatchdogStep stepSize, bool repeat = false);
+    bool kick(void);
+
+    void configureBatterySwitch(BatterySwitchThreshold threshold, BatterySwitchMode mode,
+                                bool enabled = true, bool fastRefresh = false);
+    void setClockOut(ClockOut frequency);
+    void setPeriodicInterrupt(PeriodicRate rate);
+    PeriodicRate getPeriodicInterrupt(void);
+    void setStopSource(StopSource source);
+
+    /*!
+        @brief  Bus statistics of an API group
+        @param api PCF85263_API_*
+        @return Counters since begin() or resetStats(), all 0 unless the
+                library is built with PCF85263_ENABLE_STATS
+    */
+    const PCF85263_Stats &getStats(uint8_t api) const { return stats[api < PCF85263_API_COUNT ? api : PCF85263_API_OTHER]; }
+    /*!
+        @brief  Clear the bus statistics of all API groups
+    */
+    void resetStats(void) { memset(stats, 0, sizeof(stats)); }
+
+    bool attachSecondTick(uint8_t pin, uint32_t resync_ticks = 3600, PeriodicRate rate = PERIODIC_SECOND);
+    void detachSecondTick(void);
+    bool resyncSecondTick(void);
+    DateTime tickNow(void);
+
+private:
+    friend class PCF85263Group;
+
+    PCF85263_WireTransport wire_transport;  ///< Transport used by begin(TwoWire *)
+
+    uint8_t async_buffer[7];                ///< Receives the registers of requestNow()
+    uint8_t *async_dst = NULL;              ///< Buffer of the pending transfer
+    size_t async_len = 0;                   ///< Length of the pending transfer
+    uint8_t async_reg = 0;                  ///< First register of the pending transfer
+    bool async_pending = false;             ///< A transfer was started and not yet polled to its end
+    PCF85263_NowCallback now_callback = NULL;   ///< Callback of the pending requestNow()
+    PCF85263_ReadCallback read_callback = NULL; ///< Callback of the pending requestRead()
+    DateTime async_now;                     ///< Result of the last requestNow()
+    bool consistent_read = false;           ///< now() and nowPrecise() guard against rollovers
+    PCF85263_InterruptCallback int_callbacks[PCF85263_FLAG_COUNT] = {}; ///< serviceInterrupt() handler per flag bit
+
+    static void second_tick_isr(void);
+    static uint16_t tick_seconds(PeriodicRate rate);
+    static PCF85263 *tick_instance;         ///< Device advanced by second_tick_isr()
+
+    static DateTime decode_time(const uint8_t *buffer);
+    static DateTime decode_timestamp(const uint8_t *buffer);
+    bool read_consistent(uint8_t *buffer);
+    static void encode_alarm1(uint8_t *buffer, const AlarmSpec &alarm);
+    static void encode_alarm2(uint8_t *buffer, const AlarmSpec &alarm);
+    static uint8_t alarm_enables(const AlarmSpec &alarm1, const AlarmSpec &alarm2);
+    /*!
+        @brief  Compose register Timestamp Control
+        @return Register value
+    */
+    static uint8_t timestamp_modes(TSR1Mode tsr1, TSR2Mode tsr2, TSR3Mode tsr3)
+    {
+      return (tsr3 << 6) | (tsr2 << 2) | tsr1;
+    }
+    static int8_t shadow_index(uint8_t reg);
+    bool bridgeable(uint8_t reg);
+    void refresh_control(uint8_t reg, uint8_t val);
+    static IntSources int_sources(bool pulse_mode, bool periodic_int, bool offset_correc_int, bool alarm1_int,
+                                  bool alarm2_int, bool timestamp_int, bool battery_switch_int, bool watchdog_int);
+    uint8_t read_control(uint8_t reg);
+    void write_control(uint8_t reg, uint8_t val);
+
+    uint8_t shadow[PCF85263_SHADOW_SIZE];   ///< Last known content of ALMEN and TSTMP_Control..STOPEN
+    uint16_t shadow_valid = 0;              ///< One bit per shadow entry that holds a known value
+    bool cache_enabled = false;             ///< Serve control register reads from the shadow
+    uint16_t shadow_dirty = 0;              ///< Shadow entries written inside a transaction, not yet committed
+    uint8_t txn_depth = 0;                  ///< Nesting depth of beginTransaction()/commit()
+    uint8_t wd_config = 0;                  ///< Watchdog register written by configureWatchdog(), 0 while disabled
+
+    volatile uint32_t tick_count = 0;       ///< Periodic interrupts seen since tick_base was read
+    DateTime tick_time;                     ///< Software clock, advanced to tick_applied ticks
+    uint32_t tick_applied = 0;              ///< Ticks already added to tick_time
+    uint32_t tick_resync = 0;               ///< Ticks after which tickNow() re-reads the device, 0 = never
+    int16_t tick_pin = -1;                  ///< MCU pin wired to INTA, -1 if not attached
+    uint16_t tick_period = 1;               ///< Seconds per tick: 1, 60 or 3600
 };
 
 
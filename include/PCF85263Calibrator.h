@@ -0,0 +1,73 @@
+/**************************************************************************/
+/*!
+    @file     PCF85263Calibrator.h
+    Computes and applies the frequency offset of a PCF85263 from its drift
+    against an external time reference.
+    Written by Fabian Voelker for promesstec GmbH.
+    MIT license, all text here must be included in any redistribution.
+*/
+/**************************************************************************/
+
+
+#ifndef __PCF85263CALIBRATOR_H__
+#define __PCF85263CALIBRATOR_H__
+
+#include "PCF85263.h"
+
+#define PCF85263_OFFSET_STEP_NORMAL_PPB 2170    //< Correction per offset LSB in normal mode
+#define PCF85263_OFFSET_STEP_FAST_PPB   2035    //< Correction per offset LSB in fast mode (2.0345 ppm)
+#define PCF85263_CALIBRATOR_MAX_STEP    4       //< Default offset change per apply()
+
+/**************************************************************************/
+/*!
+    @brief  Measures the drift of a PCF85263 against a reference and
+    corrects it through the offset register.
+    Call `start()` and, after a measurement window, `measure()` with the
+    reference time in milliseconds each (GPS PPS count, NTP time or the
+    MCU's `millis()`), then `apply()`. The drift is read with 1/100 s
+    resolution, so a window of one hour resolves about 3 ppm; longer
+    windows give finer results.
+    `apply()` changes the offset by at most a few LSB at a time and
+    restarts the measurement, so a noisy reference cannot throw the clock
+    off in one go. A failed device read never counts as a sample; it
+    starts a new window instead.
+    @note Enable the hundredths counter (`PCF85263::enableHundredths()`).
+        Reference times are taken modulo 2^32 ms, so a window must be
+        shorter than 49 days.
+    @note Positive offset values speed the clock up.
+*/
+/**************************************************************************/
+class PCF85263Calibrator {
+public:
+  PCF85263Calibrator()
+      : rtc(NULL), max_step(PCF85263_CALIBRATOR_MAX_STEP), start_rtc_ms(0),
+        start_ref_ms(0), drift_ppb(0), started(false), measured(false) {}
+
+  void begin(PCF85263 &rtc, uint8_t maxStep = PCF85263_CALIBRATOR_MAX_STEP);
+
+  bool start(uint32_t reference_ms);
+  bool measure(uint32_t reference_ms);
+
+  /*!
+      @brief  Drift found by the last `measure()`
+      @return Parts per billion the clock runs fast (positive) or slow
+              (negative), with the current offset in effect
+  */
+  int32_t driftPpb() const { return drift_ppb; }
+  int8_t correction(uint8_t offset_mode) const;
+  bool apply(uint32_t reference_ms);
+
+protected:
+  int8_t correction(int16_t current, uint8_t offset_mode) const;
+  static uint64_t rtc_ms(const DateTimeMs &dt);
+
+  PCF85263 *rtc;            ///< Device being calibrated
+  uint8_t max_step;         ///< Largest offset change per apply()
+  uint64_t start_rtc_ms;    ///< Device time at start() in ms since 2000
+  uint32_t start_ref_ms;    ///< Reference time at start()
+  int32_t drift_ppb;        ///< Result of the last measure()
+  bool started;             ///< start() was called
+  bool measured;            ///< drift_ppb is valid
+};
+
+#endif
@@ -0,0 +1,59 @@
+/**************************************************************************/
+/*!
+    @file     PCF85263Group.h
+    Reads several PCF85263 on separate I2C buses as close to the same
+    instant as possible.
+    Written by Fabian Voelker for promesstec GmbH.
+    MIT license, all text here must be included in any redistribution.
+*/
+/**************************************************************************/
+
+
+#ifndef __PCF85263GROUP_H__
+#define __PCF85263GROUP_H__
+
+#include "PCF85263.h"
+
+#define PCF85263_GROUP_MAX_DEVICES  4       //< Devices a PCF85263Group can hold
+#define PCF85263_GROUP_READ_LEN     8       //< Registers read per device, 100th seconds..years
+
+/**************************************************************************/
+/*!
+    @brief  A set of PCF85263, each on its own bus, that are read together.
+    `readAll()` first starts the time read on every device and only then
+    waits for and decodes the results. Devices on transports with
+    background transfers are therefore read in parallel; on blocking
+    transports the reads follow each other without any decoding in
+    between.
+    @note Enable the hundredths counter on every device
+        (`PCF85263::enableHundredths()`) to get a meaningful `spread()`.
+*/
+/**************************************************************************/
+class PCF85263Group {
+public:
+  PCF85263Group() : count(0), last_spread(0) {}
+
+  bool add(PCF85263 &rtc);
+  /*!
+      @brief  Number of devices in the group
+      @return Device count
+  */
+  uint8_t size() const { return count; }
+
+  uint8_t readAll(DateTimeMs *times, bool *valid = NULL);
+
+  /*!
+      @brief  Spread of the last `readAll()`
+      @return Hundredths of a second between the earliest and the latest
+              device that could be read
+  */
+  int32_t spread() const { return last_spread; }
+
+protected:
+  PCF85263 *devices[PCF85263_GROUP_MAX_DEVICES]; ///< Members of the group
+  uint8_t buffers[PCF85263_GROUP_MAX_DEVICES][PCF85263_GROUP_READ_LEN]; ///< Raw time registers
+  uint8_t count;        ///< Number of devices
+  int32_t last_spread;  ///< Spread of the last readAll() in hundredths
+};
+
+#endif
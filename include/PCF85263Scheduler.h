@@ -0,0 +1,96 @@
+/**************************************************************************/
+/*!
+    @file     PCF85263Scheduler.h
+    Runs many logical timers on the two hardware alarms of a PCF85263.
+    Written by Fabian Voelker for promesstec GmbH.
+    MIT license, all text here must be included in any redistribution.
+*/
+/**************************************************************************/
+
+
+#ifndef __PCF85263SCHEDULER_H__
+#define __PCF85263SCHEDULER_H__
+
+#include "PCF85263.h"
+
+#define PCF85263_SCHEDULER_MAX_JOBS 16      //< Jobs a PCF85263Scheduler can hold
+#define PCF85263_SCHEDULER_NO_JOB   0xFF    //< Returned when a job could not be added
+
+/*!
+    @brief  Callback of a scheduled job
+    @param job Id returned when the job was added
+    @param now Time the job was dispatched at
+*/
+typedef void (*PCF85263_JobCallback)(uint8_t job, const DateTime &now);
+
+/**************************************************************************/
+/*!
+    @brief  Min-heap of job deadlines on top of a PCF85263. The nearest
+    deadline is always programmed into Alarm1, and Alarm2 is set to the
+    following full minute as a backup in case Alarm1 was written just
+    after its second had passed. `service()` re-arms the backup from the
+    current time, so an overdue job runs within a minute. The MCU
+    therefore wakes once per job and not on every periodic tick.
+    Call `isr()` from the INTA handler and `service()` from the loop; the
+    callbacks run from `service()`, never from interrupt context.
+    @note Route Alarm1 and Alarm2 to INTA yourself, e.g. with
+        `setINTA()`. The scheduler owns both alarms.
+*/
+/**************************************************************************/
+class PCF85263Scheduler {
+public:
+  PCF85263Scheduler() : rtc(NULL), count(0), next_id(0), fired(false) {}
+
+  void begin(PCF85263 &rtc);
+
+  uint8_t every(const TimeSpan &period, PCF85263_JobCallback callback);
+  uint8_t at(const DateTime &when, PCF85263_JobCallback callback);
+  bool cancel(uint8_t job);
+
+  /*!
+      @brief  Mark the alarm as fired, call this from the INTA handler
+  */
+  void isr() { fired = true; }
+  /*!
+      @brief  Test if an alarm fired since the last `service()`
+      @return True if `service()` has work to do
+  */
+  bool pending() const { return fired; }
+  /*!
+      @brief  Number of scheduled jobs
+      @return Job count
+  */
+  uint8_t size() const { return count; }
+  bool next(DateTime &when) const;
+
+  uint8_t service(bool force = false);
+
+protected:
+  /*!
+      @brief  Entry of the deadline heap
+  */
+  struct Job {
+    PackedDateTime deadline;        ///< Next time the job is due
+    uint32_t period;                ///< Seconds between runs, 0 for one-shot jobs
+    PCF85263_JobCallback callback;  ///< Function to dispatch
+    uint8_t id;                     ///< Handle returned to the user
+  };
+
+  uint8_t add(const PackedDateTime &deadline, uint32_t period, PCF85263_JobCallback callback,
+              const PackedDateTime &now);
+  void push(const Job &job);
+  void remove(uint8_t index);
+  void sift_up(uint8_t index);
+  void sift_down(uint8_t index);
+  bool id_used(uint8_t id) const;
+  void arm();
+  void arm(const PackedDateTime &now);
+
+  PCF85263 *rtc;                            ///< Device whose alarms are used
+  Job heap[PCF85263_SCHEDULER_MAX_JOBS];    ///< Deadlines, earliest at index 0
+  uint8_t count;                            ///< Number of jobs in the heap
+  uint8_t next_id;                          ///< Candidate for the next job id
+  volatile bool fired;                      ///< Set by isr(), cleared by service()
+};
+
+#endif
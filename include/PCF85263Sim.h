@@ -0,0 +1,93 @@
+/**************************************************************************/
+/*!
+    @file     PCF85263Sim.h
+    Register-level simulation of a PCF85263 behind the transport interface,
+    to run and measure the driver without hardware.
+    Written by Fabian Voelker for promesstec GmbH.
+    MIT license, all text here must be included in any redistribution.
+*/
+/**************************************************************************/
+
+
+#ifndef __PCF85263SIM_H__
+#define __PCF85263SIM_H__
+
+#include "PCF85263.h"
+
+#define PCF85263_SIM_RESET_SOFTWARE 0x2C    //< RESETS command: software reset
+#define PCF85263_SIM_RESET_PRESCALER 0xA4   //< RESETS command: clear prescaler (hundredths)
+#define PCF85263_SIM_RESET_TIMESTAMP 0x25   //< RESETS command: clear timestamps
+
+/*!
+    @brief  Bus traffic between two points of a test, see
+            `PCF85263_SimTransport::counters()`
+*/
+struct PCF85263_BusCounters {
+  uint32_t transactions;   ///< Transfers started
+  uint32_t bytes_written;  ///< Bytes written, register addresses included
+  uint32_t bytes_read;     ///< Bytes read
+};
+
+/**************************************************************************/
+/*!
+    @brief  Mock transport that behaves like the device. On top of the
+    register file and the traffic counters of PCF85263_MockTransport it
+    models:
+    - the clock, advanced explicitly with `advance()`, with BCD carries
+      through months and leap years in RTC mode and up to 999999 hours in
+      stopwatch mode; the STOP bit holds it
+    - the alarms, setting A1F/A2F when their enabled fields match
+    - the timestamp registers, filled by `triggerTimestamp()` and
+      `switchSupply()` according to TSR_mode, with their flags and BSF
+    - write-0-to-clear of the flags register and the RESETS commands
+    Time only moves when the test says so, so runs are reproducible.
+    @note 12 hour mode and the watchdog counter are not modelled.
+*/
+/**************************************************************************/
+class PCF85263_SimTransport : public PCF85263_MockTransport {
+public:
+  PCF85263_SimTransport() { powerOn(); }
+
+  bool write(const uint8_t *buffer, size_t len);
+
+  void powerOn(void);
+  void advance(uint32_t hundredths);
+  void triggerTimestamp(void);
+  void switchSupply(bool battery);
+
+  /*!
+      @brief  Snapshot of the traffic counters
+      @return Counters since the last `resetCounters()`
+  */
+  PCF85263_BusCounters counters(void) const {
+    PCF85263_BusCounters c = {transactions, bytes_written, bytes_read};
+    return c;
+  }
+  /*!
+      @brief  Traffic since an earlier snapshot, e.g. of one API call
+      @param before Snapshot taken with `counters()`
+      @return Difference to the current counters
+  */
+  PCF85263_BusCounters since(const PCF85263_BusCounters &before) const {
+    PCF85263_BusCounters c = {transactions - before.transactions,
+                              bytes_written - before.bytes_written,
+                              bytes_read - before.bytes_read};
+    return c;
+  }
+
+  /*!
+      @brief  Test if the device is on battery
+      @return True after `switchSupply(true)`
+  */
+  bool onBattery(void) const { return battery; }
+
+protected:
+  void tick_second(void);
+  void check_alarms(void);
+  void record(uint8_t reg);
+  static bool inc_bcd(uint8_t &value, uint8_t first, uint8_t last);
+
+  bool battery = false;    ///< Supplied from the battery
+};
+
+#endif
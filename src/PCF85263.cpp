@@ -31,7 +31,7 @@
 /**************************************************************************/
 void RTC_I2C::write_register(uint8_t reg, uint8_t val) {
   uint8_t buffer[2] = {reg, val};
-  i2c_dev->write(buffer, 2);
+  bus_write(buffer, 2);
 }
 
 /**************************************************************************/
@@ -43,59 +43,424 @@ void RTC_I2C::write_register(uint8_t reg, uint8_t val) {
 /**************************************************************************/
 uint8_t RTC_I2C::read_register(uint8_t reg) {
   uint8_t buffer[1];
-  i2c_dev->write(&reg, 1);
-  i2c_dev->read(buffer, 1);
+  bus_write_then_read(&reg, 1, buffer, 1);
   return buffer[0];
 }
 
+#ifdef PCF85263_ENABLE_STATS
 /**************************************************************************/
-// utility code, some of this could be exposed in the DateTime API if needed
+/*!
+    @brief  Write through the transport and charge the transfer to the
+            active API group
+    @param buffer Bytes to write, the register address first
+    @param len Number of bytes
+    @return True if all bytes were acknowledged, false otherwise.
+*/
 /**************************************************************************/
+bool RTC_I2C::bus_write(const uint8_t *buffer, size_t len) {
+  uint32_t start = micros();
+  bool ok = transport->write(buffer, len);
+  record_stats(len, start, ok);
+  return ok;
+}
 
-/**
-  Number of days in each month, from January to November. December is not
-  needed. Omitting it avoids an incompatibility with Paul Stoffregen's Time
-  library. C.f. https://github.com/adafruit/RTClib/issues/114
+/**************************************************************************/
+/*!
+    @brief  Write, then read through the transport and charge the transfer
+            to the active API group
+    @param write_buffer Bytes to write, usually the register address
+    @param write_len Number of bytes to write
+    @param read_buffer Buffer receiving the bytes read
+    @param read_len Number of bytes to read
+    @return True if the transfer succeeded, false otherwise.
 */
-const uint8_t daysInMonth[] PROGMEM = {31, 28, 31, 30, 31, 30,
-                                       31, 31, 30, 31, 30};
+/**************************************************************************/
+bool RTC_I2C::bus_write_then_read(const uint8_t *write_buffer, size_t write_len,
+                                  uint8_t *read_buffer, size_t read_len) {
+  uint32_t start = micros();
+  bool ok = transport->write_then_read(write_buffer, write_len, read_buffer, read_len);
+  record_stats(write_len + read_len, start, ok);
+  return ok;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Start a read through the transport and charge it to the active
+            API group. Only the time to start the transfer is counted.
+    @param reg First register to read
+    @param read_buffer Buffer receiving the registers
+    @param read_len Number of registers to read
+    @return True if the transfer was started, false otherwise.
+*/
+/**************************************************************************/
+bool RTC_I2C::bus_start_read(uint8_t reg, uint8_t *read_buffer, size_t read_len) {
+  uint32_t start = micros();
+  bool ok = transport->start_read(reg, read_buffer, read_len);
+  record_stats(1 + read_len, start, ok);
+  return ok;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Add one transfer to the statistics of the active API group
+    @param len Bytes transferred
+    @param start micros() when the transfer began
+    @param ok Result of the transfer
+*/
+/**************************************************************************/
+void RTC_I2C::record_stats(size_t len, uint32_t start, bool ok) {
+  PCF85263_Stats &s = stats[stats_api];
+  s.micros += micros() - start;
+  s.transactions++;
+  s.bytes += len;
+  if (!ok)
+    record_error();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Count a failed transfer for the active API group, also used for
+            background reads that fail after they were started
+*/
+/**************************************************************************/
+void RTC_I2C::record_error(void) {
+  PCF85263_Stats &s = stats[stats_api];
+  s.errors++;
+  s.last_error = transport->last_error() ? transport->last_error() : PCF85263_ERR_UNKNOWN;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Charge transfers to _api_ until the scope ends, unless an outer
+            scope is already active
+    @param owner Device being measured
+    @param api PCF85263_API_*
+*/
+/**************************************************************************/
+PCF85263_StatsScope::PCF85263_StatsScope(RTC_I2C &owner, uint8_t api)
+    : owner(owner), previous(owner.stats_api) {
+  if (previous == PCF85263_API_OTHER)
+    owner.stats_api = api;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Restore the API group active before this scope
+*/
+/**************************************************************************/
+PCF85263_StatsScope::~PCF85263_StatsScope() { owner.stats_api = previous; }
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  Start reading registers. This default implementation performs
+            a blocking `write_then_read()`, so the transfer has completed
+            when it returns.
+    @param reg First register to read
+    @param read_buffer Buffer receiving the registers, must stay valid
+           until `poll()` no longer reports PCF85263_XFER_BUSY
+    @param read_len Number of registers to read
+    @return True if the transfer was started, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263_Transport::start_read(uint8_t reg, uint8_t *read_buffer,
+                                    size_t read_len) {
+  async_status = write_then_read(&reg, 1, read_buffer, read_len)
+                     ? PCF85263_XFER_DONE
+                     : PCF85263_XFER_ERROR;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Status of the transfer started by `start_read()`
+    @return PCF85263_XFER_DONE, PCF85263_XFER_BUSY or PCF85263_XFER_ERROR
+*/
+/**************************************************************************/
+uint8_t PCF85263_Transport::poll(void) { return async_status; }
+
+/**************************************************************************/
+/*!
+    @brief  Check that the device answers on the bus
+    @return True if the device was found, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263_AdafruitTransport::begin(void) { return dev && dev->begin(); }
+
+/**************************************************************************/
+/*!
+    @brief  Write bytes in one transaction
+    @param buffer Bytes to write
+    @param len Number of bytes
+    @return True on success, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263_AdafruitTransport::write(const uint8_t *buffer, size_t len) {
+  bool ok = dev->write(buffer, len);
+  error = ok ? PCF85263_ERR_NONE : PCF85263_ERR_UNKNOWN;
+  return ok;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Write bytes, then read after a repeated start. Both lengths
+            go to Adafruit_I2CDevice unchanged; this adapter does not
+            split the transfer (BusIO itself chunks reads by its
+            maxBufferSize()).
+    @param write_buffer Bytes to write
+    @param write_len Number of bytes to write
+    @param read_buffer Buffer receiving the bytes read
+    @param read_len Number of bytes to read
+    @return True on success, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263_AdafruitTransport::write_then_read(const uint8_t *write_buffer,
+                                                 size_t write_len,
+                                                 uint8_t *read_buffer,
+                                                 size_t read_len) {
+  bool ok = dev->write_then_read(write_buffer, write_len, read_buffer, read_len);
+  error = ok ? PCF85263_ERR_NONE : PCF85263_ERR_UNKNOWN;
+  return ok;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Start the bus and check that the device answers
+    @return True if the device acknowledged its address, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263_WireTransport::begin(void) {
+  wire->begin();
+  wire->beginTransmission(addr);
+  return wire->endTransmission() == 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Write bytes in one transaction
+    @param buffer Bytes to write
+    @param len Number of bytes
+    @return True if all bytes were acknowledged, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263_WireTransport::write(const uint8_t *buffer, size_t len) {
+  wire->beginTransmission(addr);
+  if (wire->write(buffer, len) != len) {
+    error = PCF85263_ERR_OVERFLOW;
+    return false;
+  }
+  error = wire->endTransmission();
+  return error == PCF85263_ERR_NONE;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Write bytes, then read after a repeated start. Reads longer
+            than PCF85263_WIRE_MAX_READ are split into several requests.
+    @param write_buffer Bytes to write
+    @param write_len Number of bytes to write
+    @param read_buffer Buffer receiving the bytes read
+    @param read_len Number of bytes to read
+    @return True on success, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263_WireTransport::write_then_read(const uint8_t *write_buffer,
+                                             size_t write_len,
+                                             uint8_t *read_buffer,
+                                             size_t read_len) {
+  wire->beginTransmission(addr);
+  if (wire->write(write_buffer, write_len) != write_len) {
+    error = PCF85263_ERR_OVERFLOW;
+    return false;
+  }
+  error = wire->endTransmission(false);
+  if (error != PCF85263_ERR_NONE)
+    return false;
+  // The register address auto-increments, so a read larger than the Wire
+  // buffer continues where the previous chunk ended
+  while (read_len) {
+    uint8_t chunk = read_len < PCF85263_WIRE_MAX_READ ? read_len : PCF85263_WIRE_MAX_READ;
+    bool last = chunk == read_len;
+    if (wire->requestFrom(addr, chunk, (uint8_t)last) != chunk) {
+      error = PCF85263_ERR_SHORT;
+      return false;
+    }
+    for (uint8_t i = 0; i < chunk; i++)
+      *read_buffer++ = wire->read();
+    read_len -= chunk;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Write to the register array, the first byte selects the start
+            register
+    @param buffer Register address followed by the values
+    @param len Number of bytes
+    @return True unless the device is marked as missing.
+*/
+/**************************************************************************/
+bool PCF85263_MockTransport::write(const uint8_t *buffer, size_t len) {
+  ++transactions;
+  bytes_written += len;
+  error = present ? PCF85263_ERR_NONE : PCF85263_ERR_NACK_ADDR;
+  if (!present || len == 0)
+    return present;
+  pointer = buffer[0] % PCF85263_REGISTER_COUNT;
+  for (size_t i = 1; i < len; i++) {
+    registers[pointer] = buffer[i];
+    pointer = (pointer + 1) % PCF85263_REGISTER_COUNT;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Select a register and read from the register array
+    @param write_buffer Register address
+    @param write_len Number of bytes to write
+    @param read_buffer Buffer receiving the registers
+    @param read_len Number of registers to read
+    @return True unless the device is marked as missing.
+*/
+/**************************************************************************/
+bool PCF85263_MockTransport::write_then_read(const uint8_t *write_buffer,
+                                             size_t write_len,
+                                             uint8_t *read_buffer,
+                                             size_t read_len) {
+  ++transactions;
+  bytes_written += write_len;
+  bytes_read += read_len;
+  error = present ? PCF85263_ERR_NONE : PCF85263_ERR_NACK_ADDR;
+  if (!present)
+    return false;
+  if (write_len)
+    pointer = write_buffer[0] % PCF85263_REGISTER_COUNT;
+  for (size_t i = 0; i < read_len; i++) {
+    read_buffer[i] = registers[pointer];
+    pointer = (pointer + 1) % PCF85263_REGISTER_COUNT;
+  }
+  return true;
+}
+
+#if defined(ARDUINO_ARCH_STM32) && defined(HAL_I2C_MODULE_ENABLED)
+/**************************************************************************/
+/*!
+    @brief  Check that the device answers on the bus
+    @return True if the device was found, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263_HALTransport::begin(void) {
+  return HAL_I2C_IsDeviceReady(hi2c, addr, 3, PCF85263_HAL_TIMEOUT_MS) ==
+         HAL_OK;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Write bytes in one transaction
+    @param buffer Bytes to write
+    @param len Number of bytes
+    @return True on success, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263_HALTransport::write(const uint8_t *buffer, size_t len) {
+  return set_error(HAL_I2C_Master_Transmit(hi2c, addr, (uint8_t *)buffer, len,
+                                           PCF85263_HAL_TIMEOUT_MS));
+}
 
 /**************************************************************************/
 /*!
-    @brief  Given a date, return number of days since 2000/01/01,
-            valid for 2000--2099
-    @param y Year
-    @param m Month
-    @param d Day
-    @return Number of days
+    @brief  Write the register address, then read after a repeated start
+    @param write_buffer Register address
+    @param write_len Number of bytes to write, only 1 is supported
+    @param read_buffer Buffer receiving the bytes read
+    @param read_len Number of bytes to read
+    @return True on success, false otherwise.
 */
 /**************************************************************************/
-static uint16_t date2days(uint16_t y, uint8_t m, uint8_t d) {
-  if (y >= 2000U)
-    y -= 2000U;
-  uint16_t days = d;
-  for (uint8_t i = 1; i < m; ++i)
-    days += pgm_read_byte(daysInMonth + i - 1);
-  if (m > 2 && y % 4 == 0)
-    ++days;
-  return days + 365 * y + (y + 3) / 4 - 1;
+bool PCF85263_HALTransport::write_then_read(const uint8_t *write_buffer,
+                                            size_t write_len,
+                                            uint8_t *read_buffer,
+                                            size_t read_len) {
+  if (write_len != 1) {
+    error = PCF85263_ERR_OVERFLOW;
+    return false;
+  }
+  return set_error(HAL_I2C_Mem_Read(hi2c, addr, write_buffer[0],
+                                    I2C_MEMADD_SIZE_8BIT, read_buffer, read_len,
+                                    PCF85263_HAL_TIMEOUT_MS));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Start a register read by DMA or interrupt and return at once
+    @param reg First register to read
+    @param read_buffer Buffer receiving the registers
+    @param read_len Number of registers to read
+    @return True if the transfer was started, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263_HALTransport::start_read(uint8_t reg, uint8_t *read_buffer,
+                                       size_t read_len) {
+  HAL_StatusTypeDef status =
+      use_dma ? HAL_I2C_Mem_Read_DMA(hi2c, addr, reg, I2C_MEMADD_SIZE_8BIT,
+                                     read_buffer, read_len)
+              : HAL_I2C_Mem_Read_IT(hi2c, addr, reg, I2C_MEMADD_SIZE_8BIT,
+                                    read_buffer, read_len);
+  async_status = set_error(status) ? PCF85263_XFER_BUSY : PCF85263_XFER_ERROR;
+  return status == HAL_OK;
 }
 
 /**************************************************************************/
 /*!
-    @brief  Given a number of days, hours, minutes, and seconds, return the
-   total seconds
-    @param days Days
-    @param h Hours
-    @param m Minutes
-    @param s Seconds
-    @return Number of seconds total
+    @brief  Status of the transfer started by `start_read()`
+    @return PCF85263_XFER_DONE, PCF85263_XFER_BUSY or PCF85263_XFER_ERROR
 */
 /**************************************************************************/
-static uint32_t time2ulong(uint16_t days, uint8_t h, uint8_t m, uint8_t s) {
-  return ((days * 24UL + h) * 60 + m) * 60 + s;
+uint8_t PCF85263_HALTransport::poll(void) {
+  if (async_status != PCF85263_XFER_BUSY)
+    return async_status;
+  if (HAL_I2C_GetState(hi2c) != HAL_I2C_STATE_READY)
+    return PCF85263_XFER_BUSY;
+  async_status = set_error(HAL_I2C_GetError(hi2c) == HAL_I2C_ERROR_NONE ? HAL_OK : HAL_ERROR)
+                     ? PCF85263_XFER_DONE
+                     : PCF85263_XFER_ERROR;
+  return async_status;
 }
 
+/**************************************************************************/
+/*!
+    @brief  Translate a HAL result into last_error()
+    @param status Result of a HAL call
+    @return True if the call succeeded, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263_HALTransport::set_error(HAL_StatusTypeDef status) {
+  if (status == HAL_OK)
+    error = PCF85263_ERR_NONE;
+  else if (status == HAL_TIMEOUT)
+    error = PCF85263_ERR_TIMEOUT;
+  else if (HAL_I2C_GetError(hi2c) & HAL_I2C_ERROR_AF)
+    error = PCF85263_ERR_NACK_DATA;
+  else
+    error = PCF85263_ERR_BUS;
+  return status == HAL_OK;
+}
+#endif
+
+/**************************************************************************/
+// utility code, some of this could be exposed in the DateTime API if needed
+/**************************************************************************/
+
+/**
+  Number of days in each month, from January to November. December is not
+  needed. Omitting it avoids an incompatibility with Paul Stoffregen's Time
+  library. C.f. https://github.com/adafruit/RTClib/issues/114
+*/
+const uint8_t daysInMonth[] PROGMEM = {31, 28, 31, 30, 31, 30,
+                                       31, 31, 30, 31, 30};
+
 /**************************************************************************/
 /*!
     @brief  Constructor from
@@ -127,122 +492,19 @@ DateTime::DateTime(uint32_t t) {
   t /= 60;
   hh = t % 24;
   uint16_t days = t / 24;
-  uint8_t leap;
-  for (yOff = 0;; ++yOff) {
-    leap = yOff % 4 == 0;
-    if (days < 365U + leap)
-      break;
-    days -= 365 + leap;
-  }
-  for (m = 1; m < 12; ++m) {
-    uint8_t daysPerMonth = pgm_read_byte(daysInMonth + m - 1);
-    if (leap && m == 2)
-      ++daysPerMonth;
-    if (days < daysPerMonth)
-      break;
-    days -= daysPerMonth;
-  }
-  d = days + 1;
-}
-
-/**************************************************************************/
-/*!
-    @brief  Constructor from (year, month, day, hour, minute, second).
-    @warning If the provided parameters are not valid (e.g. 31 February),
-           the constructed DateTime will be invalid.
-    @see   The `isValid()` method can be used to test whether the
-           constructed DateTime is valid.
-    @param year Either the full year (range: 2000--2099) or the offset from
-        year 2000 (range: 0--99).
-    @param month Month number (1--12).
-    @param day Day of the month (1--31).
-    @param hour,min,sec Hour (0--23), minute (0--59) and second (0--59).
-*/
-/**************************************************************************/
-DateTime::DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour,
-                   uint8_t min, uint8_t sec) {
-  if (year >= 2000U)
-    year -= 2000U;
-  yOff = year;
-  m = month;
-  d = day;
-  hh = hour;
-  mm = min;
-  ss = sec;
-}
-
-/**************************************************************************/
-/*!
-    @brief  Copy constructor.
-    @param copy DateTime to copy.
-*/
-/**************************************************************************/
-DateTime::DateTime(const DateTime &copy)
-    : yOff(copy.yOff), m(copy.m), d(copy.d), hh(copy.hh), mm(copy.mm),
-      ss(copy.ss) {}
-
-/**************************************************************************/
-/*!
-    @brief  Convert a string containing two digits to uint8_t, e.g. "09" returns
-   9
-    @param p Pointer to a string containing two digits
-*/
-/**************************************************************************/
-static uint8_t conv2d(const char *p) {
-  uint8_t v = 0;
-  if ('0' <= *p && *p <= '9')
-    v = *p - '0';
-  return 10 * v + *++p - '0';
-}
 
-/**************************************************************************/
-/*!
-    @brief  Constructor for generating the build time.
-    This constructor expects its parameters to be strings in the format
-    generated by the compiler's preprocessor macros `__DATE__` and
-    `__TIME__`. Usage:
-    ```
-    DateTime buildTime(__DATE__, __TIME__);
-    ```
-    @note The `F()` macro can be used to reduce the RAM footprint, see
-        the next constructor.
-    @param date Date string, e.g. "Apr 16 2020".
-    @param time Time string, e.g. "18:34:56".
-*/
-/**************************************************************************/
-DateTime::DateTime(const char *date, const char *time) {
-  yOff = conv2d(date + 9);
-  // Jan Feb Mar Apr May Jun Jul Aug Sep Oct Nov Dec
-  switch (date[0]) {
-  case 'J':
-    m = (date[1] == 'a') ? 1 : ((date[2] == 'n') ? 6 : 7);
-    break;
-  case 'F':
-    m = 2;
-    break;
-  case 'A':
-    m = date[2] == 'r' ? 4 : 8;
-    break;
-  case 'M':
-    m = date[2] == 'r' ? 3 : 5;
-    break;
-  case 'S':
-    m = 9;
-    break;
-  case 'O':
-    m = 10;
-    break;
-  case 'N':
-    m = 11;
-    break;
-  case 'D':
-    m = 12;
-    break;
-  }
-  d = conv2d(date + 4);
-  hh = conv2d(time);
-  mm = conv2d(time + 3);
-  ss = conv2d(time + 6);
+  // Count from 1996-03-01, so that each four year cycle ends with the leap
+  // day and the month lengths from March on follow the (153 * m + 2) / 5
+  // pattern. Every fourth year is a leap year, as in date2days().
+  uint32_t z = days + 1461U - 60U;
+  uint16_t cycle = z / 1461U;
+  uint16_t doc = z % 1461U;                     // day of cycle [0, 1460]
+  uint8_t yoc = (doc - doc / 1460U) / 365U;     // year of cycle [0, 3]
+  uint16_t doy = doc - 365U * yoc;              // day of year from March 1st
+  uint8_t mp = (5U * doy + 2U) / 153U;          // month from March [0, 11]
+  d = doy - (153U * mp + 2U) / 5U + 1U;
+  m = mp < 10 ? mp + 3 : mp - 9;
+  yOff = 4U * cycle + yoc + (m <= 2) - 4U;
 }
 
 /**************************************************************************/
@@ -253,6 +515,10 @@ DateTime::DateTime(const char *date, const char *time) {
     ```
     DateTime buildTime(F(__DATE__), F(__TIME__));
     ```
+    @note Program memory cannot be read at compile time, so unlike
+        `DateTime(const char *, const char *)` this one parses at run time.
+        Prefer `constexpr DateTime buildTime(__DATE__, __TIME__)`, which
+        needs neither RAM nor flash for the strings.
     @param date Date PROGMEM string, e.g. F("Apr 16 2020").
     @param time Time PROGMEM string, e.g. F("18:34:56").
 */
@@ -261,66 +527,13 @@ DateTime::DateTime(const __FlashStringHelper *date,
                    const __FlashStringHelper *time) {
   char buff[11];
   memcpy_P(buff, date, 11);
-  yOff = conv2d(buff + 9);
-  // Jan Feb Mar Apr May Jun Jul Aug Sep Oct Nov Dec
-  switch (buff[0]) {
-  case 'J':
-    m = (buff[1] == 'a') ? 1 : ((buff[2] == 'n') ? 6 : 7);
-    break;
-  case 'F':
-    m = 2;
-    break;
-  case 'A':
-    m = buff[2] == 'r' ? 4 : 8;
-    break;
-  case 'M':
-    m = buff[2] == 'r' ? 3 : 5;
-    break;
-  case 'S':
-    m = 9;
-    break;
-  case 'O':
-    m = 10;
-    break;
-  case 'N':
-    m = 11;
-    break;
-  case 'D':
-    m = 12;
-    break;
-  }
-  d = conv2d(buff + 4);
+  yOff = conv2d(buff[9], buff[10]);
+  m = month_from_name(buff);
+  d = conv2d(buff[4], buff[5]);
   memcpy_P(buff, time, 8);
-  hh = conv2d(buff);
-  mm = conv2d(buff + 3);
-  ss = conv2d(buff + 6);
-}
-
-/**************************************************************************/
-/*!
-    @brief  Constructor for creating a DateTime from an ISO8601 date string.
-    This constructor expects its parameters to be a string in the
-    https://en.wikipedia.org/wiki/ISO_8601 format, e.g:
-    "2020-06-25T15:29:37"
-    Usage:
-    ```
-    DateTime dt("2020-06-25T15:29:37");
-    ```
-    @note The year must be > 2000, as only the yOff is considered.
-    @param iso8601dateTime
-           A dateTime string in iso8601 format,
-           e.g. "2020-06-25T15:29:37".
-*/
-/**************************************************************************/
-DateTime::DateTime(const char *iso8601dateTime) {
-  char ref[] = "2000-01-01T00:00:00";
-  memcpy(ref, iso8601dateTime, min(strlen(ref), strlen(iso8601dateTime)));
-  yOff = conv2d(ref + 2);
-  m = conv2d(ref + 5);
-  d = conv2d(ref + 8);
-  hh = conv2d(ref + 11);
-  mm = conv2d(ref + 14);
-  ss = conv2d(ref + 17);
+  hh = conv2d(buff[0], buff[1]);
+  mm = conv2d(buff[3], buff[4]);
+  ss = conv2d(buff[6], buff[7]);
 }
 
 /**************************************************************************/
@@ -330,11 +543,13 @@ DateTime::DateTime(const char *iso8601dateTime) {
 */
 /**************************************************************************/
 bool DateTime::isValid() const {
-  if (yOff >= 100)
+  if (yOff >= 100 || m < 1 || m > 12 || d < 1 || hh >= 24 || mm >= 60 ||
+      ss >= 60)
     return false;
-  DateTime other(unixtime());
-  return yOff == other.yOff && m == other.m && d == other.d && hh == other.hh &&
-         mm == other.mm && ss == other.ss;
+  uint8_t daysPerMonth = (m == 12) ? 31 : pgm_read_byte(daysInMonth + m - 1);
+  if (m == 2 && yOff % 4 == 0)
+    ++daysPerMonth;
+  return d <= daysPerMonth;
 }
 
 /**************************************************************************/
@@ -377,8 +592,11 @@ bool DateTime::isValid() const {
 /**************************************************************************/
 
 char *DateTime::toString(char *buffer) const {
-  uint8_t apTag =
-      (strstr(buffer, "ap") != nullptr) || (strstr(buffer, "AP") != nullptr);
+  size_t len = strlen(buffer);
+  uint8_t apTag = false;
+  for (size_t i = 0; i + 1 < len && !apTag; i++)
+    apTag = (buffer[i] == 'a' && buffer[i + 1] == 'p') ||
+            (buffer[i] == 'A' && buffer[i + 1] == 'P');
   uint8_t hourReformatted = 0, isPM = false;
   if (apTag) {     // 12 Hour Mode
     if (hh == 0) { // midnight
@@ -396,7 +614,7 @@ char *DateTime::toString(char *buffer) const {
     }
   }
 
-  for (size_t i = 0; i < strlen(buffer) - 1; i++) {
+  for (size_t i = 0; i + 1 < len; i++) {
     if (buffer[i] == 'h' && buffer[i + 1] == 'h') {
       if (!apTag) { // 24 Hour Mode
         buffer[i] = '0' + hh / 10;
@@ -466,6 +684,144 @@ char *DateTime::toString(char *buffer) const {
   return buffer;
 }
 
+/**************************************************************************/
+/*!
+    @brief  Compile a `toString()` format string.
+    @see `DateTime::toString(char *)` for the supported specifiers.
+    @param format Format string, e.g. "DDD, DD MMM YYYY hh:mm:ss".
+*/
+/**************************************************************************/
+DateTimeFormat::DateTimeFormat(const char *format)
+    : _size(0), _outLen(0), _twelveHour(false) {
+  static const uint8_t tokenLength[] PROGMEM = {0, 4, 2, 3, 2, 3, 2,
+                                                2, 2, 2, 2, 2};
+  const char *p = format;
+  while (*p && _size < PCF85263_FORMAT_MAX_LEN) {
+    uint8_t tok = 0;
+    if (p[0] == 'h' && p[1] == 'h')
+      tok = TOKEN_hh;
+    else if (p[0] == 'm' && p[1] == 'm')
+      tok = TOKEN_mm;
+    else if (p[0] == 's' && p[1] == 's')
+      tok = TOKEN_ss;
+    else if (p[0] == 'D' && p[1] == 'D')
+      tok = p[2] == 'D' ? TOKEN_DDD : TOKEN_DD;
+    else if (p[0] == 'M' && p[1] == 'M')
+      tok = p[2] == 'M' ? TOKEN_MMM : TOKEN_MM;
+    else if (p[0] == 'Y' && p[1] == 'Y')
+      tok = (p[2] == 'Y' && p[3] == 'Y') ? TOKEN_YYYY : TOKEN_YY;
+    else if (p[0] == 'A' && p[1] == 'P')
+      tok = TOKEN_AP;
+    else if (p[0] == 'a' && p[1] == 'p')
+      tok = TOKEN_ap;
+
+    if (!tok) {
+      _program[_size++] = *p++;
+      ++_outLen;
+      continue;
+    }
+    if (_size + 2 > PCF85263_FORMAT_MAX_LEN)
+      break;
+    _program[_size++] = 0;
+    _program[_size++] = tok;
+    _outLen += pgm_read_byte(tokenLength + tok);
+    _twelveHour |= (tok == TOKEN_AP || tok == TOKEN_ap);
+    p += (tok == TOKEN_YYYY) ? 4 : (tok == TOKEN_DDD || tok == TOKEN_MMM) ? 3 : 2;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes the DateTime using a compiled format.
+    Unlike `toString(char *)`, the buffer does not hold the format and is
+    not scanned: the program in _format_ is executed once from start to
+    end, so the cost is linear in the output length and nothing is
+    allocated.
+    @param[out] buffer Array of `char` receiving the formatted DateTime.
+    @param len Size of _buffer_. The output is truncated to len - 1
+        characters and always NUL-terminated.
+    @param format Format compiled by the DateTimeFormat constructor.
+    @return A pointer to the provided buffer.
+*/
+/**************************************************************************/
+char *DateTime::toString(char *buffer, size_t len,
+                         const DateTimeFormat &format) const {
+  static PROGMEM const char day_names[] = "SunMonTueWedThuFriSat";
+  static PROGMEM const char month_names[] =
+      "JanFebMarAprMayJunJulAugSepOctNovDec";
+  if (len == 0)
+    return buffer;
+
+  uint8_t hour = format._twelveHour ? twelveHour() : hh;
+  char *out = buffer;
+  char *end = buffer + len - 1;
+  for (uint8_t i = 0; i < format._size && out < end; i++) {
+    if (format._program[i]) {
+      *out++ = format._program[i];
+      continue;
+    }
+    char field[4];
+    uint8_t n = 2;
+    const char *name = nullptr;
+    int16_t value = -1;
+    switch (format._program[++i]) {
+    case DateTimeFormat::TOKEN_YYYY:
+      field[0] = '2';
+      field[1] = '0';
+      field[2] = '0' + (yOff / 10) % 10;
+      field[3] = '0' + yOff % 10;
+      n = 4;
+      break;
+    case DateTimeFormat::TOKEN_YY:
+      field[0] = '0' + (yOff / 10) % 10;
+      field[1] = '0' + yOff % 10;
+      break;
+    case DateTimeFormat::TOKEN_MMM:
+      name = &month_names[3 * (m - 1)];
+      break;
+    case DateTimeFormat::TOKEN_DDD:
+      name = &day_names[3 * dayOfTheWeek()];
+      break;
+    case DateTimeFormat::TOKEN_AP:
+      field[0] = isPM() ? 'P' : 'A';
+      field[1] = 'M';
+      break;
+    case DateTimeFormat::TOKEN_ap:
+      field[0] = isPM() ? 'p' : 'a';
+      field[1] = 'm';
+      break;
+    case DateTimeFormat::TOKEN_MM:
+      value = m;
+      break;
+    case DateTimeFormat::TOKEN_DD:
+      value = d;
+      break;
+    case DateTimeFormat::TOKEN_hh:
+      value = hour;
+      break;
+    case DateTimeFormat::TOKEN_mm:
+      value = mm;
+      break;
+    default: // TOKEN_ss
+      value = ss;
+      break;
+    }
+    if (name) {
+      field[0] = pgm_read_byte(name);
+      field[1] = pgm_read_byte(name + 1);
+      field[2] = pgm_read_byte(name + 2);
+      n = 3;
+    } else if (value >= 0) {
+      field[0] = '0' + value / 10;
+      field[1] = '0' + value % 10;
+    }
+    for (uint8_t k = 0; k < n && out < end; k++)
+      *out++ = field[k];
+  }
+  *out = 0;
+  return buffer;
+}
+
 /**************************************************************************/
 /*!
       @brief  Return the hour in 12-hour format.
@@ -484,47 +840,82 @@ uint8_t DateTime::twelveHour() const {
 
 /**************************************************************************/
 /*!
-    @brief  Return the day of the week.
-    @return Day of week as an integer from 0 (Sunday) to 6 (Saturday).
+    @brief  Advance by one second in place. The carry runs through
+            minutes, hours, days, months and years as far as needed, so the
+            common case is a single compare.
 */
 /**************************************************************************/
-uint8_t DateTime::dayOfTheWeek() const {
-  uint16_t day = date2days(yOff, m, d);
-  return (day + 6) % 7; // Jan 1, 2000 is a Saturday, i.e. returns 6
+void DateTime::tick() {
+  if (++ss < 60)
+    return;
+  ss = 0;
+  if (++mm < 60)
+    return;
+  mm = 0;
+  if (++hh < 24)
+    return;
+  hh = 0;
+  next_day();
 }
 
 /**************************************************************************/
 /*!
-    @brief  Return Unix time: seconds since 1 Jan 1970.
-    @see The `DateTime::DateTime(uint32_t)` constructor is the converse of
-        this method.
-    @return Number of seconds since 1970-01-01 00:00:00.
+    @brief  Advance by a number of seconds in place. Spans of less than a
+            day are carried field by field; longer ones go through
+            `unixtime()` and the `DateTime(uint32_t)` constructor.
+    @param seconds Seconds to add
 */
 /**************************************************************************/
-uint32_t DateTime::unixtime(void) const {
-  uint32_t t;
-  uint16_t days = date2days(yOff, m, d);
-  t = time2ulong(days, hh, mm, ss);
-  t += SECONDS_FROM_1970_TO_2000; // seconds from 1970 to 2000
-
-  return t;
+void DateTime::advance(uint32_t seconds) {
+  if (seconds >= (uint32_t)SECONDS_PER_DAY) {
+    *this = DateTime(unixtime() + seconds);
+    return;
+  }
+  if (seconds < 60) {
+    ss += seconds;
+    if (ss < 60)
+      return;
+    ss -= 60;
+    seconds = 60; // carry one minute below
+  } else {
+    seconds += ss;
+    ss = seconds % 60;
+  }
+  uint16_t minutes = mm + (uint16_t)(seconds / 60);
+  if (minutes < 60) {
+    mm = minutes;
+    return;
+  }
+  mm = minutes % 60;
+  uint8_t hours = hh + minutes / 60;
+  if (hours < 24) {
+    hh = hours;
+    return;
+  }
+  hh = hours - 24;
+  next_day();
 }
 
 /**************************************************************************/
 /*!
-    @brief  Convert the DateTime to seconds since 1 Jan 2000
-    The result can be converted back to a DateTime with:
-    ```cpp
-    DateTime(SECONDS_FROM_1970_TO_2000 + value)
-    ```
-    @return Number of seconds since 2000-01-01 00:00:00.
+    @brief  Move to the next day, keeping the time of day
 */
 /**************************************************************************/
-uint32_t DateTime::secondstime(void) const {
-  uint32_t t;
-  uint16_t days = date2days(yOff, m, d);
-  t = time2ulong(days, hh, mm, ss);
-  return t;
+void DateTime::next_day() {
+  uint8_t last = (m == 12) ? 31 : pgm_read_byte(daysInMonth + m - 1);
+  if (m == 2 && yOff % 4 == 0)
+    last++;
+  if (d < last) {
+    d++;
+    return;
+  }
+  d = 1;
+  if (m < 12) {
+    m++;
+    return;
+  }
+  m = 1;
+  yOff++;
 }
 
 /**************************************************************************/
@@ -535,6 +926,11 @@ uint32_t DateTime::secondstime(void) const {
 */
 /**************************************************************************/
 DateTime DateTime::operator+(const TimeSpan &span) const {
+  if (span.totalseconds() >= 0 && span.totalseconds() < SECONDS_PER_DAY) {
+    DateTime result(*this);
+    result.advance(span.totalseconds());
+    return result;
+  }
   return DateTime(unixtime() + span.totalseconds());
 }
 
@@ -576,16 +972,14 @@ TimeSpan DateTime::operator-(const DateTime &right) const {
 */
 /**************************************************************************/
 bool DateTime::operator<(const DateTime &right) const {
-  return (yOff + 2000U < right.year() ||
-          (yOff + 2000U == right.year() &&
-           (m < right.month() ||
-            (m == right.month() &&
-             (d < right.day() ||
-              (d == right.day() &&
-               (hh < right.hour() ||
-                (hh == right.hour() &&
-                 (mm < right.minute() ||
-                  (mm == right.minute() && ss < right.second()))))))))));
+  // Each field fits a byte, so the fields packed most significant first
+  // order the same way as the field by field comparison.
+  uint32_t date = (uint32_t)yOff << 16 | (uint32_t)m << 8 | d;
+  uint32_t rightDate = (uint32_t)right.yOff << 16 | (uint32_t)right.m << 8 | right.d;
+  if (date != rightDate)
+    return date < rightDate;
+  uint32_t time = (uint32_t)hh << 16 | (uint32_t)mm << 8 | ss;
+  return time < ((uint32_t)right.hh << 16 | (uint32_t)right.mm << 8 | right.ss);
 }
 
 /**************************************************************************/
@@ -605,6 +999,7 @@ bool DateTime::operator==(const DateTime &right) const {
           right.second() == ss);
 }
 
+#ifndef PCF85263_NO_HEAP
 /**************************************************************************/
 /*!
     @brief  Return a ISO 8601 timestamp as a `String` object.
@@ -619,23 +1014,71 @@ bool DateTime::operator==(const DateTime &right) const {
 /**************************************************************************/
 String DateTime::timestamp(timestampOpt opt) const {
   char buffer[25]; // large enough for any DateTime, including invalid ones
+  return String(timestamp(buffer, sizeof(buffer), opt));
+}
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  Write a number with at least two digits, like "%02u"
+    @param p Output position
+    @param v Value to write
+    @return Position after the last digit written
+*/
+/**************************************************************************/
+static char *put2d(char *p, uint16_t v) {
+  if (v >= 1000)
+    *p++ = '0' + v / 1000;
+  if (v >= 100)
+    *p++ = '0' + v / 100 % 10;
+  *p++ = '0' + v / 10 % 10;
+  *p++ = '0' + v % 10;
+  return p;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Write a ISO 8601 timestamp into a caller supplied buffer.
+    Same output as `timestamp(timestampOpt)`, but without `sprintf()` and
+    without allocating a `String`.
+    @param[out] buffer Array of `char` receiving the timestamp. 20 bytes
+        hold any valid DateTime with TIMESTAMP_FULL, 25 bytes any DateTime.
+    @param len Size of _buffer_
+    @param opt Format of the timestamp
+    @return A pointer to the provided buffer, or nullptr if _len_ is too
+        small for the timestamp. The buffer then holds an empty string.
+*/
+/**************************************************************************/
+char *DateTime::timestamp(char *buffer, size_t len, timestampOpt opt) const {
+  char tmp[25];
+  char *p = tmp;
+
+  if (opt != TIMESTAMP_TIME) {
+    p = put2d(p, 2000U + yOff);
+    *p++ = '-';
+    p = put2d(p, m);
+    *p++ = '-';
+    p = put2d(p, d);
+    if (opt == TIMESTAMP_FULL)
+      *p++ = 'T';
+  }
+  if (opt != TIMESTAMP_DATE) {
+    p = put2d(p, hh);
+    *p++ = ':';
+    p = put2d(p, mm);
+    *p++ = ':';
+    p = put2d(p, ss);
+  }
 
-  // Generate timestamp according to opt
-  switch (opt) {
-  case TIMESTAMP_TIME:
-    // Only time
-    sprintf(buffer, "%02d:%02d:%02d", hh, mm, ss);
-    break;
-  case TIMESTAMP_DATE:
-    // Only date
-    sprintf(buffer, "%u-%02d-%02d", 2000U + yOff, m, d);
-    break;
-  default:
-    // Full
-    sprintf(buffer, "%u-%02d-%02dT%02d:%02d:%02d", 2000U + yOff, m, d, hh, mm,
-            ss);
+  size_t n = p - tmp;
+  if (n >= len) {
+    if (len)
+      buffer[0] = 0;
+    return nullptr;
   }
-  return String(buffer);
+  memcpy(buffer, tmp, n);
+  buffer[n] = 0;
+  return buffer;
 }
 
 /**************************************************************************/
@@ -700,296 +1143,1736 @@ TimeSpan TimeSpan::operator-(const TimeSpan &right) const {
 
 
 
+PCF85263 *PCF85263::tick_instance = NULL;
+
 /**************************************************************************/
 /*!
     @brief  Start I2C for the PCF85263 and test succesful connection
     @param  wireInstance pointer to the I2C bus
+    @param  useCache true to keep a shadow copy of the control registers in
+            RAM. The shadow is filled here by `syncCache()` and setters
+            then skip the read of their read-modify-write cycle.
     @return True if Wire can find PCF85263 or false otherwise.
 */
 /**************************************************************************/
-bool PCF85263::begin(TwoWire *wireInstance) 
+bool PCF85263::begin(TwoWire *wireInstance, bool useCache)
 {
-  if (i2c_dev)
-    delete i2c_dev;
-  i2c_dev = new Adafruit_I2CDevice(PCF85263_ADDRESS, wireInstance);
-  if (!i2c_dev->begin())
-    return false;
-  return true;
+  PCF85263_STATS_SCOPE(PCF85263_API_BEGIN);
+  wire_transport.setBus(wireInstance);
+  return begin(wire_transport, useCache);
 }
 
 /**************************************************************************/
 /*!
-    @brief  Resets the STOP bit in register Stop Enable
+    @brief  Start the PCF85263 on a user supplied transport, e.g. a
+            `PCF85263_HALTransport`, and test succesful connection
+    @param  bus Transport to the device, must outlive this object
+    @param  useCache true to keep a shadow copy of the control registers,
+            see `begin(TwoWire *, bool)`
+    @return True if the transport can find PCF85263 or false otherwise.
 */
 /**************************************************************************/
-void PCF85263::start(void) 
+bool PCF85263::begin(PCF85263_Transport &bus, bool useCache)
 {
-  uint8_t stopen = read_register(PCF85263_STOPEN);
-  if (stopen & (0b00000001))
-    write_register(PCF85263_STOPEN, stopen & ~(0b00000001));
+  PCF85263_STATS_SCOPE(PCF85263_API_BEGIN);
+  transport = &bus;
+  async_pending = false;
+  if (!transport->begin())
+    return false;
+  cache_enabled = useCache;
+  invalidateCache();
+  if (cache_enabled)
+    return syncCache();
+  return true;
 }
 
 /**************************************************************************/
 /*!
-    @brief  Sets the STOP bit in register Stop Enable
+    @brief  Refill the shadow cache from the device. ALMEN and the control
+            block TSTMP_Control..STOPEN are fetched with two burst reads
+            on purpose: one burst from ALMEN would also carry the 18
+            timestamp registers between them, 31 bytes instead of 13.
+    @note   Call this whenever the registers may have been changed behind
+            the driver's back, e.g. by another bus master or after the
+            device lost power.
+    @return True if both reads succeeded, false otherwise.
 */
 /**************************************************************************/
-void PCF85263::stop(void) 
+bool PCF85263::syncCache(void)
 {
-  uint8_t stopen = read_register(PCF85263_STOPEN);
-  if (!(stopen & (0b00000001)))
-    write_register(PCF85263_STOPEN, stopen & (0b00000001));
+  PCF85263_STATS_SCOPE(PCF85263_API_BEGIN);
+  uint8_t buffer[PCF85263_CTRL_BURST_LEN];
+  uint8_t reg = PCF85263_ALMEN;
+  if (!bus_write_then_read(&reg, 1, buffer, 1))
+    return false;
+  refresh_control(PCF85263_ALMEN, buffer[0]);
+  reg = PCF85263_TSTMP_Control;
+  if (!bus_write_then_read(&reg, 1, buffer, PCF85263_CTRL_BURST_LEN))
+    return false;
+  for (uint8_t i = 0; i < PCF85263_CTRL_BURST_LEN; i++)
+    if (PCF85263_TSTMP_Control + i != PCF85263_FLAGS)
+      refresh_control(PCF85263_TSTMP_Control + i, buffer[i]);
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Mark the whole shadow cache as stale. The next access to a
+            control register goes to the device again.
+*/
+/**************************************************************************/
+void PCF85263::invalidateCache(void)
+{
+  shadow_valid = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Map a register address onto its slot in the shadow cache.
+            FLAGS is set by the hardware and RESETS is a command register,
+            so neither of them can be served from a shadow copy.
+    @param  reg register address
+    @return Index into shadow, or -1 if the register is not cached.
+*/
+/**************************************************************************/
+int8_t PCF85263::shadow_index(uint8_t reg)
+{
+  if (reg == PCF85263_ALMEN)
+    return 0;
+  if (reg < PCF85263_TSTMP_Control || reg > PCF85263_STOPEN || reg == PCF85263_FLAGS)
+    return -1;
+  return reg - PCF85263_TSTMP_Control + 1;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read a control register, from the shadow cache if enabled
+    @param  reg register address
+    @return value of register
+*/
+/**************************************************************************/
+uint8_t PCF85263::read_control(uint8_t reg)
+{
+  int8_t idx = shadow_index(reg);
+  if (idx < 0)
+    return read_register(reg);
+  if ((cache_enabled || txn_depth) && (shadow_valid & (1U << idx)))
+    return shadow[idx];
+  shadow[idx] = read_register(reg);
+  shadow_valid |= (1U << idx);
+  return shadow[idx];
+}
+
+/**************************************************************************/
+/*!
+    @brief  Write a control register and keep the shadow cache in step
+    @param  reg register address
+    @param  val value to write
+*/
+/**************************************************************************/
+void PCF85263::write_control(uint8_t reg, uint8_t val)
+{
+  int8_t idx = shadow_index(reg);
+  if (idx < 0)
+  {
+    write_register(reg, val);
+    return;
+  }
+  shadow[idx] = val;
+  shadow_valid |= (1U << idx);
+  if (txn_depth)
+    shadow_dirty |= (1U << idx);
+  else
+    write_register(reg, val);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Store a value just read from or written to the device in the
+            shadow cache. A dirty entry is left alone, so a write pending in
+            an open transaction is not lost.
+    @param  reg register address
+    @param  val value of the register
+*/
+/**************************************************************************/
+void PCF85263::refresh_control(uint8_t reg, uint8_t val)
+{
+  int8_t idx = shadow_index(reg);
+  if (idx < 0 || (shadow_dirty & (1U << idx)))
+    return;
+  shadow[idx] = val;
+  shadow_valid |= (1U << idx);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Start collecting control register changes. Until the matching
+            commit(), setters only update the shadow cache and no write
+            reaches the bus. Transactions may be nested; only the outermost
+            commit() writes. Without the cache, the outermost call drops
+            the shadow values left by earlier calls, so the setters start
+            from what the device holds now.
+*/
+/**************************************************************************/
+void PCF85263::beginTransaction(void)
+{
+  if (txn_depth++ == 0 && !cache_enabled)
+    shadow_valid &= shadow_dirty;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Write all registers changed since beginTransaction(). ALMEN and
+            the control block are written as auto-increment bursts; runs of
+            changed registers separated by up to PCF85263_BURST_MAX_GAP
+            registers that can be rewritten safely are merged into one burst,
+            see bridgeable(). Registers of a failed burst stay dirty and are
+            written again by the next commit().
+    @return True if all bursts were acknowledged, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263::commit(void)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_CONFIGURE);
+  if (txn_depth == 0 || --txn_depth)
+    return true;
+
+  uint16_t failed = 0;
+  if (shadow_dirty & 1U)
+  {
+    uint8_t buffer[2] = {PCF85263_ALMEN, shadow[0]};
+    if (!bus_write(buffer, 2))
+      failed |= 1U;
+  }
+
+  uint8_t idx = 1;
+  while (idx < PCF85263_SHADOW_SIZE)
+  {
+    if (!(shadow_dirty & (1U << idx)))
+    {
+      ++idx;
+      continue;
+    }
+    // Extend the burst as long as the next dirty entry is close enough and
+    // everything in between can be rewritten with its current value.
+    uint8_t last = idx;
+    for (uint8_t next = idx + 1; next < PCF85263_SHADOW_SIZE && next - last <= PCF85263_BURST_MAX_GAP + 1; ++next)
+    {
+      if (shadow_dirty & (1U << next))
+      {
+        last = next;
+        continue;
+      }
+      if (!bridgeable(next - 1 + PCF85263_TSTMP_Control))
+        break;
+    }
+
+    uint8_t buffer[PCF85263_CTRL_BURST_LEN + 1];
+    uint8_t len = 0;
+    buffer[len++] = idx - 1 + PCF85263_TSTMP_Control;
+    for (uint8_t i = idx; i <= last; ++i)
+      buffer[len++] = (i - 1 + PCF85263_TSTMP_Control == PCF85263_FLAGS) ? 0xFF : shadow[i];
+    if (!bus_write(buffer, len))
+      failed |= shadow_dirty & (((1U << (last + 1)) - 1) & ~((1U << idx) - 1));
+    idx = last + 1;
+  }
+
+  shadow_dirty = failed;
+  return failed == 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Check whether a clean register may be rewritten to join two
+            bursts of commit(). FLAGS is written as 0xFF, which leaves every
+            flag untouched. RAM and WD never are: a stale RAM byte would
+            overwrite the live one and writing WD restarts the watchdog.
+            Other registers only if the cache holds their value.
+    @param  reg register address
+    @return True if _reg_ can be written without changing the device
+*/
+/**************************************************************************/
+bool PCF85263::bridgeable(uint8_t reg)
+{
+  if (reg == PCF85263_FLAGS)
+    return true;
+  if (reg == PCF85263_RAM || reg == PCF85263_WD)
+    return false;
+  return cache_enabled && (shadow_valid & (1U << shadow_index(reg)));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Resets the STOP bit in register Stop Enable
+*/
+/**************************************************************************/
+void PCF85263::start(void)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_START_STOP);
+  uint8_t stopen = read_control(PCF85263_STOPEN);
+  if (stopen & (0b00000001))
+    write_control(PCF85263_STOPEN, stopen & ~(0b00000001));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the STOP bit in register Stop Enable
+*/
+/**************************************************************************/
+void PCF85263::stop(void)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_START_STOP);
+  uint8_t stopen = read_control(PCF85263_STOPEN);
+  if (!(stopen & (0b00000001)))
+    write_control(PCF85263_STOPEN, stopen | (0b00000001));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the STOP bit in register Stop Enable
+*/
+/**************************************************************************/
+void PCF85263::configure(void)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_CONFIGURE);
+  beginTransaction();
+
+  //Timestamp Control Register Factory settings
+  write_control(PCF85263_TSTMP_Control,
+                timestamp_modes(TSR1_OFF, TSR2_FIRST_BATTERY, TSR3_LAST_BATTERY));
+
+  //PINIO Control Register
+  write_control(PCF85263_PINIO, 0b00000010);
+
+  //INTA Control Register
+  write_control(PCF85263_INTAEN, 0b00010000);
+
+  //Enable INTA Register
+  uint8_t alrm_en = read_control(PCF85263_ALMEN);
+  write_control(PCF85263_ALMEN, (alrm_en | (0x1F)));
+
+  commit();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Set the date and time
+    @param dt DateTime to set
+*/
+/**************************************************************************/
+void PCF85263::adjust(const DateTime &dt) 
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_ADJUST);
+  uint8_t buffer[8] = {PCF85263_SECOND, // start at location 1, SECONDS
+                       bin2bcd(dt.second()), bin2bcd(dt.minute()),
+                       bin2bcd(dt.hour()),   bin2bcd(dt.day()),
+                       dt.dayOfTheWeek(), // needed by weekday alarms
+                       bin2bcd(dt.month()),  bin2bcd(dt.year() - 2000U)};
+  bus_write(buffer, 8);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the current date/time
+    @return DateTime object containing the current date/time, or the
+            invalid `DateTime(0, 0, 0)` if the device could not be read;
+            the transport's `last_error()` tells why.
+*/
+/**************************************************************************/
+DateTime PCF85263::now() 
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_NOW);
+  while (poll() == PCF85263_XFER_BUSY)
+    ; // finish a transfer that is already in flight
+  if (consistent_read)
+  {
+    uint8_t buffer[PCF85263_RAW_TIME_FULL_LEN];
+    if (!read_consistent(buffer))
+      return DateTime(0, 0, 0);
+    async_now = decode_time(buffer + 1);
+    return async_now;
+  }
+  if (!requestNow())
+    return DateTime(0, 0, 0);
+  uint8_t status;
+  while ((status = poll()) == PCF85263_XFER_BUSY)
+    ;
+  if (status != PCF85263_XFER_DONE)
+    return DateTime(0, 0, 0);
+  return async_now;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Start reading the current date/time without waiting for it.
+            With a transport that supports background transfers the CPU is
+            free until `poll()` reports completion; the result is then
+            passed to _callback_.
+    @param callback Function called by `poll()` with the date/time, or NULL
+    @return True if the read was started, false if another transfer is
+            still pending or the transport refused it.
+*/
+/**************************************************************************/
+bool PCF85263::requestNow(PCF85263_NowCallback callback)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_NOW);
+  if (!requestRead(PCF85263_SECOND, async_buffer, 7))
+    return false;
+  now_callback = callback;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Start reading a block of registers without waiting for it
+    @param reg First register to read
+    @param buffer Buffer receiving the registers, must stay valid until
+           the transfer completed
+    @param len Number of registers to read
+    @param callback Function called by `poll()` with the registers, or NULL
+    @return True if the read was started, false if another transfer is
+            still pending or the transport refused it.
+*/
+/**************************************************************************/
+bool PCF85263::requestRead(uint8_t reg, uint8_t *buffer, size_t len,
+                           PCF85263_ReadCallback callback)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_ASYNC);
+  if (async_pending)
+    return false;
+  async_reg = reg;
+  async_dst = buffer;
+  async_len = len;
+  now_callback = NULL;
+  read_callback = callback;
+  if (!bus_start_read(reg, buffer, len))
+    return false;
+  async_pending = true;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Drive the pending transfer of `requestNow()`/`requestRead()`
+            and run its callback once it completed
+    @return PCF85263_XFER_BUSY while the transfer runs, PCF85263_XFER_DONE
+            once it completed (or if none is pending) and
+            PCF85263_XFER_ERROR if it failed.
+*/
+/**************************************************************************/
+uint8_t PCF85263::poll(void)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_ASYNC);
+  if (!async_pending)
+    return PCF85263_XFER_DONE;
+  uint8_t status = transport->poll();
+  if (status == PCF85263_XFER_BUSY)
+    return status;
+
+  async_pending = false;
+  if (status != PCF85263_XFER_DONE)
+  {
+    record_error();
+    return status;
+  }
+  if (async_dst == async_buffer)
+  {
+    async_now = decode_time(async_buffer);
+    if (now_callback)
+      now_callback(async_now);
+  }
+  else if (read_callback)
+  {
+    read_callback(async_reg, async_dst, async_len);
+  }
+  return status;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read registers into a caller buffer without decoding them.
+            Blocks like `now()`; use `requestRead()` for a background read.
+    @param reg First register, e.g. PCF85263_TSTMP1_SECONDS for all
+               timestamp registers
+    @param dst Buffer receiving _len_ registers
+    @param len Number of registers, the address wraps after RESETS
+    @return True if the read succeeded, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263::readRaw(uint8_t reg, uint8_t *dst, size_t len)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_ASYNC);
+  while (poll() == PCF85263_XFER_BUSY)
+    ; // the bus may be busy with a background read
+  return bus_write_then_read(&reg, 1, dst, len);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Capture the time registers 100TH_SECONDS..YEAR with one burst
+            and no decoding, see RawTime
+    @param[out] raw Receives the registers
+    @return True if the read succeeded, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263::readRawTime(RawTime &raw)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_NOW);
+  return readRaw(PCF85263_100TH_SECONDS, raw.regs, PCF85263_RAW_TIME_FULL_LEN);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the current date/time including the hundredths of a second.
+            The 100th seconds register is fetched in the same burst as the
+            time registers, so this costs one byte more than now().
+    @note   The device only counts hundredths when enabled with
+            `enableHundredths(true)`; otherwise hundredth() reads 0.
+    @return DateTimeMs object containing the current date/time, or the
+            invalid `DateTime(0, 0, 0)` if the device could not be read
+*/
+/**************************************************************************/
+DateTimeMs PCF85263::nowPrecise()
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_NOW_PRECISE);
+  uint8_t buffer[PCF85263_RAW_TIME_FULL_LEN];
+  bool ok;
+  if (consistent_read)
+    ok = read_consistent(buffer);
+  else
+  {
+    buffer[0] = PCF85263_100TH_SECONDS;
+    ok = bus_write_then_read(buffer, 1, buffer, PCF85263_RAW_TIME_FULL_LEN);
+  }
+  if (!ok)
+    return DateTimeMs(DateTime(0, 0, 0), 0);
+
+  return DateTimeMs(decode_time(buffer + 1), bcd2bin(buffer[0]));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Enables the 100th seconds counter (100TH bit in register Function)
+    @param en True enables counting of hundredths, False disables it
+*/
+/**************************************************************************/
+void PCF85263::enableHundredths(bool en)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_STOPWATCH);
+  uint8_t funct = read_control(PCF85263_FUNCT);
+  if(en)
+  {
+    write_control(PCF85263_FUNCT, (funct | (0x80)));
+  }
+  else
+  {
+    write_control(PCF85263_FUNCT, (funct & ~(0x80)));
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Switches between RTC mode and stopwatch mode (RTCM bit in
+            register Function). In stopwatch mode the time registers form a
+            counter of up to 999,999 hours with 1/100 s resolution.
+    @note   Stop the clock with `stop()` before switching and load the
+            counter with `adjust()` or `setStopwatch()` afterwards, the
+            register contents are not converted by the device.
+    @param stopwatch_mode True selects stopwatch mode, False RTC mode
+*/
+/**************************************************************************/
+void PCF85263::setStopwatchMode(bool stopwatch_mode)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_STOPWATCH);
+  uint8_t funct = read_control(PCF85263_FUNCT);
+  if(stopwatch_mode)
+  {
+    write_control(PCF85263_FUNCT, (funct | (0x10)));
+  }
+  else
+  {
+    write_control(PCF85263_FUNCT, (funct & ~(0x10)));
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns whether the device runs in stopwatch mode
+    @return True in stopwatch mode, False in RTC mode
+*/
+/**************************************************************************/
+bool PCF85263::getStopwatchMode(void)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_STOPWATCH);
+  uint8_t funct = read_control(PCF85263_FUNCT);
+  return ((funct & 0x10) >> 4);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read the stopwatch counter. All six counter registers are
+            fetched in one burst, so the value is consistent.
+    @return Elapsed time in hundredths of a second, or
+            PCF85263_STOPWATCH_INVALID if the device could not be read;
+            the transport's `last_error()` tells why.
+*/
+/**************************************************************************/
+StopwatchTicks PCF85263::readStopwatch()
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_STOPWATCH);
+  uint8_t buffer[6];
+  buffer[0] = PCF85263_100TH_SECONDS;
+  if (!bus_write_then_read(buffer, 1, buffer, 6))
+    return PCF85263_STOPWATCH_INVALID;
+
+  uint32_t hours = (bcd2bin(buffer[5]) * 100UL + bcd2bin(buffer[4])) * 100UL +
+                   bcd2bin(buffer[3]);
+  uint32_t centis = (bcd2bin(buffer[2] & 0x7F) * 60UL + bcd2bin(buffer[1] & 0x7F)) * 100UL +
+                    bcd2bin(buffer[0]);
+  return hours * 360000ULL + centis;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Load the stopwatch counter with one burst write
+    @param ticks Elapsed time in hundredths of a second, clipped to
+           999,999 h 59 min 59.99 s
+*/
+/**************************************************************************/
+void PCF85263::setStopwatch(StopwatchTicks ticks)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_STOPWATCH);
+  if (ticks >= (PCF85263_SW_HOURS_MAX + 1) * 360000ULL)
+    ticks = (PCF85263_SW_HOURS_MAX + 1) * 360000ULL - 1;
+  uint32_t hours = ticks / 360000ULL;
+  uint32_t centis = ticks % 360000ULL;
+
+  uint8_t buffer[7] = {PCF85263_100TH_SECONDS,
+                       bin2bcd(centis % 100), bin2bcd(centis / 100 % 60),
+                       bin2bcd(centis / 6000),
+                       bin2bcd(hours % 100), bin2bcd(hours / 100 % 100),
+                       bin2bcd(hours / 10000)};
+  bus_write(buffer, 7);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Make `now()` and `nowPrecise()` consistent across rollovers.
+    The device freezes its counters for the duration of a burst read, so
+    a single burst from register 100TH_SECONDS is self-consistent. A read
+    taken just before a second ends may however be stale by the time a
+    slow or clock-stretched transfer completes, so when the hundredths
+    are at PCF85263_ROLLOVER_GUARD or later, hundredths and seconds are
+    read again (2 bytes) and replace the first ones if the second moved
+    on within the same minute. If seconds carried into the minute, the
+    first burst is kept: it is consistent and at most a few hundredths
+    old, while bringing minutes through years up to date would need the
+    whole block again. A read therefore costs one transaction of 8 bytes,
+    or two with 10 bytes near the end of a second.
+    Enabling the mode also enables the hundredths counter, which it needs.
+    @param en True to enable the checked reads, false for the plain
+              7-byte read of `now()`
+*/
+/**************************************************************************/
+void PCF85263::setConsistentRead(bool en)
+{
+  consistent_read = en;
+  if (en)
+    enableHundredths(true);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read 100TH_SECONDS..YEAR with at most one extra 2-byte read
+            around a rollover, as described in `setConsistentRead()`
+    @param[out] buffer Receives PCF85263_RAW_TIME_FULL_LEN registers
+    @return True if the reads succeeded, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263::read_consistent(uint8_t *buffer)
+{
+  uint8_t reg = PCF85263_100TH_SECONDS;
+  if (!bus_write_then_read(&reg, 1, buffer, PCF85263_RAW_TIME_FULL_LEN))
+    return false;
+  if (bcd2bin(buffer[0]) < PCF85263_ROLLOVER_GUARD)
+    return true;
+
+  uint8_t check[2];
+  if (!bus_write_then_read(&reg, 1, check, 2))
+    return false;
+  if ((check[1] & 0x7F) == (buffer[1] & 0x7F))
+  {
+    buffer[0] = check[0];
+    return true;
+  }
+  if ((check[1] & 0x7F) != 0)
+  {
+    // the second advanced within the same minute
+    buffer[0] = check[0];
+    buffer[1] = check[1];
+  }
+  // else the minute carried: keep the latched first burst
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Convert raw time snapshots into unixtimes in bulk.
+    Each snapshot is PCF85263_RAW_TIME_LEN bytes of the registers SECOND to
+    YEAR, as read by `now()`. All seven bytes are masked and converted from
+    BCD at once as lanes of one 64-bit word, and the day count uses the
+    March-based month formula, so the loop has no data dependent branches.
+    @param raw n snapshots, back to back
+    @param n Number of snapshots
+    @param[out] unixtimes n unixtimes
+*/
+/**************************************************************************/
+void PCF85263::decodeTimes(const uint8_t *raw, size_t n, uint32_t *unixtimes)
+{
+  // lanes: second, minute, hour, day, weekday, month, year
+  const uint64_t field_mask = 0x00FF1F073F3F7F7FULL;
+  const uint64_t nibbles = 0x0F0F0F0F0F0F0F0FULL;
+  for (size_t i = 0; i < n; i++, raw += PCF85263_RAW_TIME_LEN)
+  {
+    uint64_t x = 0;
+    for (uint8_t k = 0; k < PCF85263_RAW_TIME_LEN; k++)
+      x |= (uint64_t)raw[k] << (8 * k);
+    x &= field_mask;
+    x = (x & nibbles) + ((x >> 4) & nibbles) * 10; // no lane exceeds 255
+
+    uint8_t sec = x, min = x >> 8, hour = x >> 16, day = x >> 24;
+    uint8_t month = x >> 40, year = x >> 48;
+
+    // days since 1996-03-01, which lies 1401 days before 2000-01-01
+    uint8_t before_march = month <= 2;
+    uint16_t y = year + 4 - before_march;
+    uint8_t mp = month + 12 * before_march - 3;
+    uint32_t days = 365UL * y + y / 4 + (153U * mp + 2U) / 5U + day - 1 - 1401;
+    unixtimes[i] = ((days * 24 + hour) * 60 + min) * 60 + sec + SECONDS_FROM_1970_TO_2000;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Convert unixtimes into raw time snapshots in bulk, the inverse
+            of `decodeTimes()`. The fields are converted to BCD four at a
+            time as 16-bit lanes of a 64-bit word.
+    @param unixtimes n unixtimes, 2000--2099
+    @param n Number of times
+    @param[out] raw n snapshots of PCF85263_RAW_TIME_LEN bytes, back to back
+*/
+/**************************************************************************/
+void PCF85263::encodeTimes(const uint32_t *unixtimes, size_t n, uint8_t *raw)
+{
+  const uint64_t nibble_lanes = 0x000F000F000F000FULL;
+  for (size_t i = 0; i < n; i++, raw += PCF85263_RAW_TIME_LEN)
+  {
+    DateTime dt(unixtimes[i]);
+    uint16_t days = dt.secondstime() / SECONDS_PER_DAY;
+    uint64_t lo = (uint64_t)dt.second() | (uint64_t)dt.minute() << 16 |
+                  (uint64_t)dt.hour() << 32 | (uint64_t)dt.day() << 48;
+    uint64_t hi = (uint64_t)((days + 6) % 7) | (uint64_t)dt.month() << 16 |
+                  (uint64_t)(dt.year() - 2000U) << 32;
+    // tens = v * 103 >> 10 for v <= 99, then bcd = v + 6 * tens
+    lo += 6 * (((lo * 103) >> 10) & nibble_lanes);
+    hi += 6 * (((hi * 103) >> 10) & nibble_lanes);
+    raw[0] = lo;
+    raw[1] = lo >> 16;
+    raw[2] = lo >> 32;
+    raw[3] = lo >> 48;
+    raw[4] = hi;
+    raw[5] = hi >> 16;
+    raw[6] = hi >> 32;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Decode the seconds..years registers of the RTC
+    @param buffer Register content starting at register seconds
+    @return DateTime object containing the decoded date/time
+*/
+/**************************************************************************/
+DateTime PCF85263::decode_time(const uint8_t *buffer)
+{
+  return DateTime(bcd2bin(buffer[6]) + 2000U, bcd2bin(buffer[5] & 0x1F),
+                  bcd2bin(buffer[3] & 0x3F), bcd2bin(buffer[2] & 0x3F),
+                  bcd2bin(buffer[1] & 0x7F), bcd2bin(buffer[0] & 0x7F));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Set the date and time of alarm1
+    @param dt DateTime to set
+*/
+/**************************************************************************/
+void PCF85263::setAlarm(const DateTime &dt) 
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_ALARM);
+  uint8_t buffer[6] = {PCF85263_ALM1_SECONDS, // start at location 1, SECONDS
+                       bin2bcd(dt.second()), bin2bcd(dt.minute()),
+                       bin2bcd(dt.hour()),   bin2bcd(dt.day()),
+                       bin2bcd(dt.month())};
+  bus_write(buffer, 6);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the current date/time from alarm1
+    @return DateTime object containing the current date/time from alarm1
+*/
+/**************************************************************************/
+DateTime PCF85263::getAlarm() 
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_ALARM);
+  uint8_t buffer[5];
+  buffer[0] = PCF85263_ALM1_SECONDS; // start at location 2, VL_SECONDS
+  bus_write_then_read(buffer, 1, buffer, 5);
+
+  return DateTime(0 + 2000U, bcd2bin(buffer[4] & 0x1F),
+                  bcd2bin(buffer[3] & 0x3F), bcd2bin(buffer[2] & 0x3F),
+                  bcd2bin(buffer[1] & 0x7F), bcd2bin(buffer[0] & 0x7F));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Enables alarm1 and start the comparison
+    @param en True enables alarm1, False disable alarm1
+*/
+/**************************************************************************/
+uint8_t PCF85263::enableAlarm(bool en)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_ALARM);
+  uint8_t alrm_en = read_control(PCF85263_ALMEN);
+  if(en)
+  {
+    write_control(PCF85263_ALMEN, (alrm_en | (0x1F)));
+  }
+  else
+  {
+    write_control(PCF85263_ALMEN, (alrm_en & ~(0x1F)));
+  }
+  alrm_en = read_control(PCF85263_ALMEN);
+  return alrm_en;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Program Alarm1 with a per-field enable mask. The Alarm2 enable
+            bits are left unchanged.
+    @param alarm Alarm condition, fields of Alarm2 only are ignored
+*/
+/**************************************************************************/
+void PCF85263::setAlarm1(const AlarmSpec &alarm)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_ALARM);
+  uint8_t buffer[6] = {PCF85263_ALM1_SECONDS};
+  encode_alarm1(buffer + 1, alarm);
+  bus_write(buffer, 6);
+
+  uint8_t alrm_en = read_control(PCF85263_ALMEN);
+  write_control(PCF85263_ALMEN, (alrm_en & ~PCF85263_ALMEN_ALARM1) |
+                                    alarm_enables(alarm, AlarmSpec::never()));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Program Alarm2 with a per-field enable mask. The Alarm1 enable
+            bits are left unchanged.
+    @param alarm Alarm condition, fields of Alarm1 only are ignored
+*/
+/**************************************************************************/
+void PCF85263::setAlarm2(const AlarmSpec &alarm)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_ALARM);
+  uint8_t buffer[4] = {PCF85263_ALM2_MINUTE};
+  encode_alarm2(buffer + 1, alarm);
+  bus_write(buffer, 4);
+
+  uint8_t alrm_en = read_control(PCF85263_ALMEN);
+  write_control(PCF85263_ALMEN, (alrm_en & ~PCF85263_ALMEN_ALARM2) |
+                                    alarm_enables(AlarmSpec::never(), alarm));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Program both alarms and their enable bits with one burst
+            (ALM1_SECONDS..ALMEN), without reading anything. Inside a
+            transaction the enables are written by `commit()`.
+    @param alarm1 Condition of Alarm1
+    @param alarm2 Condition of Alarm2
+*/
+/**************************************************************************/
+void PCF85263::setAlarms(const AlarmSpec &alarm1, const AlarmSpec &alarm2)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_ALARM);
+  uint8_t buffer[10] = {PCF85263_ALM1_SECONDS};
+  encode_alarm1(buffer + 1, alarm1);
+  encode_alarm2(buffer + 6, alarm2);
+  buffer[9] = alarm_enables(alarm1, alarm2);
+  if (txn_depth)
+  {
+    // the enables are queued like every other change of the transaction
+    bus_write(buffer, 9);
+    write_control(PCF85263_ALMEN, buffer[9]);
+    return;
+  }
+  bus_write(buffer, 10);
+  refresh_control(PCF85263_ALMEN, buffer[9]);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read both alarms and their enable bits with one burst
+    @param[out] alarm1 Condition of Alarm1
+    @param[out] alarm2 Condition of Alarm2
+    @return True if the read succeeded, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263::getAlarms(AlarmSpec &alarm1, AlarmSpec &alarm2)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_ALARM);
+  uint8_t buffer[9];
+  buffer[0] = PCF85263_ALM1_SECONDS;
+  if (!bus_write_then_read(buffer, 1, buffer, 9))
+    return false;
+
+  uint8_t alrm_en = buffer[8];
+  alarm1 = AlarmSpec{bcd2bin(buffer[0] & 0x7F), bcd2bin(buffer[1] & 0x7F),
+                     bcd2bin(buffer[2] & 0x3F), bcd2bin(buffer[3] & 0x3F),
+                     bcd2bin(buffer[4] & 0x1F), 0,
+                     (uint8_t)(alrm_en & PCF85263_ALMEN_ALARM1)};
+  uint8_t mask2 = 0;
+  if (alrm_en & (1 << 5)) mask2 |= PCF85263_ALARM_MINUTE;
+  if (alrm_en & (1 << 6)) mask2 |= PCF85263_ALARM_HOUR;
+  if (alrm_en & (1 << 7)) mask2 |= PCF85263_ALARM_WEEKDAY;
+  alarm2 = AlarmSpec{0, bcd2bin(buffer[5] & 0x7F), bcd2bin(buffer[6] & 0x3F),
+                     1, 1, (uint8_t)(buffer[7] & 0x07), mask2};
+
+  refresh_control(PCF85263_ALMEN, alrm_en);
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read the interrupt flags
+    @return Register Flags, see PCF85263_FLAG_*
+*/
+/**************************************************************************/
+uint8_t PCF85263::getFlags()
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_FLAGS);
+  return read_register(PCF85263_FLAGS);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Clear interrupt flags. Writing 0 clears a flag and writing 1
+            leaves it alone, so flags raised since they were read are not
+            lost.
+    @param mask PCF85263_FLAG_* bits to clear
+*/
+/**************************************************************************/
+void PCF85263::clearFlags(uint8_t mask)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_FLAGS);
+  write_register(PCF85263_FLAGS, (uint8_t)~mask);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Register the handler of one or more interrupt flags for
+            `serviceInterrupt()`
+    @param flags PCF85263_FLAG_* bits the handler is called for
+    @param callback Handler, NULL to remove the handler of _flags_
+*/
+/**************************************************************************/
+void PCF85263::onInterrupt(uint8_t flags, PCF85263_InterruptCallback callback)
+{
+  for (uint8_t bit = 0; bit < PCF85263_FLAG_COUNT; bit++)
+    if (flags & (1 << bit))
+      int_callbacks[bit] = callback;
 }
 
 /**************************************************************************/
 /*!
-    @brief  Sets the STOP bit in register Stop Enable
+    @brief  Find out why INTA or INTB fired and dispatch to the handlers of
+            `onInterrupt()`. The flags are read once, the flags that have a
+            handler are cleared in one write and then the handlers are
+            called, lowest bit first. Flags without a handler stay set for
+            `getFlags()` / `clearFlags()`; flags raised after the read are
+            not lost.
+            Bus traffic per wake is fixed by what is registered: without
+            timestamps it is a 1-byte read of FLAGS. If a timestamp flag
+            has a handler or _timestamps_ is given, the read instead is one
+            burst of PCF85263_INT_BURST_LEN (27) bytes, TSTMP1_SECONDS up
+            to FLAGS, so the timestamps come with the flags. Either way a
+            2-byte write clears the handled flags, if any.
+            Alarm handlers get no alarm data: the alarm registers only
+            hold the match pattern, which `getAlarms()` reads if needed.
+    @note Call this from the main loop after the pin interrupt, not from
+        the interrupt handler itself.
+    @param[out] timestamps Optional, receives the timestamp registers
+    @return Flags that were set, 0 if the device could not be read
 */
 /**************************************************************************/
-void PCF85263::configure(void) 
+uint8_t PCF85263::serviceInterrupt(PCF85263_Timestamps *timestamps)
 {
-  //Timestamp Control Register Factory settings
-  write_register(PCF85263_TSTMP_Control, 0b10000100);
+  PCF85263_STATS_SCOPE(PCF85263_API_FLAGS);
+  bool with_timestamps = timestamps != NULL;
+  for (uint8_t bit = 0; bit < PCF85263_FLAG_COUNT; bit++)
+    if ((PCF85263_FLAG_TIMESTAMPS & (1 << bit)) && int_callbacks[bit])
+      with_timestamps = true;
+
+  uint8_t buffer[PCF85263_INT_BURST_LEN];
+  uint8_t flags;
+  if (with_timestamps)
+  {
+    buffer[0] = PCF85263_TSTMP1_SECONDS;
+    if (!bus_write_then_read(buffer, 1, buffer, PCF85263_INT_BURST_LEN))
+      return 0;
+    flags = buffer[PCF85263_INT_BURST_LEN - 1];
+    // TSTMP_Control..INTB_enable came along, refresh what the cache does
+    // not hold newer values for
+    for (uint8_t reg = PCF85263_TSTMP_Control; reg < PCF85263_FLAGS; reg++)
+      refresh_control(reg, buffer[reg - PCF85263_TSTMP1_SECONDS]);
+  }
+  else
+  {
+    buffer[0] = PCF85263_FLAGS;
+    if (!bus_write_then_read(buffer, 1, buffer, 1))
+      return 0;
+    flags = buffer[0];
+  }
 
-  //PINIO Control Register
-  write_register(PCF85263_PINIO, 0b00000010);
+  uint8_t handled = 0;
+  for (uint8_t bit = 0; bit < PCF85263_FLAG_COUNT; bit++)
+    if ((flags & (1 << bit)) && int_callbacks[bit])
+      handled |= (1 << bit);
+  if (handled)
+  {
+    uint8_t clear[2] = {PCF85263_FLAGS, (uint8_t)~handled};
+    bus_write(clear, 2);
+  }
 
-  //INTA Control Register
-  write_register(PCF85263_INTAEN, 0b00010000);
+  DateTime tsr[3];
+  if (with_timestamps)
+  {
+    for (uint8_t i = 0; i < 3; i++)
+      tsr[i] = decode_timestamp(buffer + 6 * i);
+    if (timestamps)
+    {
+      timestamps->tsr1 = tsr[0];
+      timestamps->tsr2 = tsr[1];
+      timestamps->tsr3 = tsr[2];
+      timestamps->mode = buffer[PCF85263_TSTMP_Control - PCF85263_TSTMP1_SECONDS];
+    }
+  }
 
-  //Enable INTA Register
-  uint8_t alrm_en = read_register(PCF85263_ALMEN);
-  write_register(PCF85263_ALMEN, (alrm_en | (0x1F)));
+  for (uint8_t bit = 0; bit < PCF85263_FLAG_COUNT; bit++)
+    if (handled & (1 << bit))
+      int_callbacks[bit](1 << bit, (PCF85263_FLAG_TIMESTAMPS & (1 << bit)) ? &tsr[bit] : NULL);
+  return flags;
 }
 
 /**************************************************************************/
 /*!
-    @brief  Set the date and time
-    @param dt DateTime to set
+    @brief  Read the battery-backed RAM byte
+    @return Register RAM Byte
 */
 /**************************************************************************/
-void PCF85263::adjust(const DateTime &dt) 
+uint8_t PCF85263::readRam(void)
 {
-  uint8_t buffer[8] = {PCF85263_SECOND, // start at location 1, SECONDS
-                       bin2bcd(dt.second()), bin2bcd(dt.minute()),
-                       bin2bcd(dt.hour()),   bin2bcd(dt.day()),
-                       bin2bcd(0), // skip weekdays
-                       bin2bcd(dt.month()),  bin2bcd(dt.year() - 2000U)};
-  i2c_dev->write(buffer, 8);
+  PCF85263_STATS_SCOPE(PCF85263_API_RAM);
+  return read_control(PCF85263_RAM);
 }
 
 /**************************************************************************/
 /*!
-    @brief  Get the current date/time
-    @return DateTime object containing the current date/time
+    @brief  Write the battery-backed RAM byte
+    @param value New content
 */
 /**************************************************************************/
-DateTime PCF85263::now() 
+void PCF85263::writeRam(uint8_t value)
 {
-  uint8_t buffer[7];
-  buffer[0] = PCF85263_SECOND; // start at location 2, VL_SECONDS
-  i2c_dev->write_then_read(buffer, 1, buffer, 7);
-
-  return DateTime(bcd2bin(buffer[6]) + 2000U, bcd2bin(buffer[5] & 0x1F),
-                  bcd2bin(buffer[3] & 0x3F), bcd2bin(buffer[2] & 0x3F),
-                  bcd2bin(buffer[1] & 0x7F), bcd2bin(buffer[0] & 0x7F));
+  PCF85263_STATS_SCOPE(PCF85263_API_RAM);
+  write_control(PCF85263_RAM, value);
 }
 
 /**************************************************************************/
 /*!
-    @brief  Set the date and time of alarm1
-    @param dt DateTime to set
+    @brief  Classify the current boot and count it in the RAM byte, instead
+            of keeping a boot counter in flash.
+            One burst reads FLAGS, RAM and the seconds register (with the
+            OS bit). A set OS bit means the oscillator stopped, so time and
+            RAM are lost: a cold start, and the sequence restarts at 0. A
+            set BSF means VDD failed and the device ran from the battery: a
+            brown-out, whose time is taken from Timestamp3 (last switch-over
+            to battery, as set by `configure()`). Otherwise it is a warm
+            reset. The new sequence number and the cleared BSF are written
+            back with one burst.
+    @note   The OS bit stays set until the time is set with `adjust()`,
+            so until then every boot reports a cold start.
+    @return Kind of boot, sequence number and the last battery switch-over
 */
 /**************************************************************************/
-void PCF85263::setAlarm(const DateTime &dt) 
+PCF85263_BootInfo PCF85263::registerBoot(void)
 {
-  uint8_t buffer[6] = {PCF85263_ALM1_SECONDS, // start at location 1, SECONDS
-                       bin2bcd(dt.second()), bin2bcd(dt.minute()),
-                       bin2bcd(dt.hour()),   bin2bcd(dt.day()),
-                       bin2bcd(dt.month())};
-  i2c_dev->write(buffer, 6);
+  PCF85263_STATS_SCOPE(PCF85263_API_RAM);
+  PCF85263_BootInfo info;
+  uint8_t buffer[PCF85263_BOOT_BURST_LEN];
+  buffer[0] = PCF85263_FLAGS;
+  if (!bus_write_then_read(buffer, 1, buffer, PCF85263_BOOT_BURST_LEN))
+  {
+    info.kind = PCF85263_BOOT_COLD;
+    info.sequence = 0;
+    return info;
+  }
+
+  uint8_t flags = buffer[0];
+  uint8_t ram = buffer[1];
+  bool osc_stopped = buffer[PCF85263_BOOT_BURST_LEN - 1] & 0x80;
+
+  if (osc_stopped)
+  {
+    info.kind = PCF85263_BOOT_COLD;
+    info.sequence = 0;
+  }
+  else
+  {
+    info.kind = (flags & PCF85263_FLAG_BATTERY) ? PCF85263_BOOT_BROWNOUT : PCF85263_BOOT_WARM;
+    info.sequence = ram + 1;
+  }
+  if (info.kind == PCF85263_BOOT_BROWNOUT)
+    info.lastBatterySwitch = getTimestampLastBatSw();
+
+  uint8_t update[3] = {PCF85263_FLAGS, (uint8_t)~PCF85263_FLAG_BATTERY, info.sequence};
+  bus_write(update, 3);
+
+  refresh_control(PCF85263_RAM, info.sequence);
+  return info;
 }
 
 /**************************************************************************/
 /*!
-    @brief  Get the current date/time from alarm1
-    @return DateTime object containing the current date/time from alarm1
+    @brief  Encode the five Alarm1 registers
+    @param buffer Receives ALM1_SECONDS..ALM1_MONTH
+    @param alarm Alarm condition
 */
 /**************************************************************************/
-DateTime PCF85263::getAlarm() 
+void PCF85263::encode_alarm1(uint8_t *buffer, const AlarmSpec &alarm)
 {
-  uint8_t buffer[5];
-  buffer[0] = PCF85263_ALM1_SECONDS; // start at location 2, VL_SECONDS
-  i2c_dev->write_then_read(buffer, 1, buffer, 5);
+  buffer[0] = bin2bcd(alarm.second);
+  buffer[1] = bin2bcd(alarm.minute);
+  buffer[2] = bin2bcd(alarm.hour);
+  buffer[3] = bin2bcd(alarm.day);
+  buffer[4] = bin2bcd(alarm.month);
+}
 
-  return DateTime(0 + 2000U, bcd2bin(buffer[4] & 0x1F),
-                  bcd2bin(buffer[3] & 0x3F), bcd2bin(buffer[2] & 0x3F),
-                  bcd2bin(buffer[1] & 0x7F), bcd2bin(buffer[0] & 0x7F));
+/**************************************************************************/
+/*!
+    @brief  Encode the three Alarm2 registers
+    @param buffer Receives ALM2_MINUTE..ALM2_WEEKDAY
+    @param alarm Alarm condition
+*/
+/**************************************************************************/
+void PCF85263::encode_alarm2(uint8_t *buffer, const AlarmSpec &alarm)
+{
+  buffer[0] = bin2bcd(alarm.minute);
+  buffer[1] = bin2bcd(alarm.hour);
+  buffer[2] = alarm.weekday;
 }
 
 /**************************************************************************/
 /*!
-    @brief  Enables alarm1 and start the comparison
-    @param en True enables alarm1, False disable alarm1
+    @brief  Compose register Alarm Enable from the masks of both alarms
+    @param alarm1 Condition of Alarm1
+    @param alarm2 Condition of Alarm2
+    @return Register value
 */
 /**************************************************************************/
-uint8_t PCF85263::enableAlarm(bool en)
+uint8_t PCF85263::alarm_enables(const AlarmSpec &alarm1, const AlarmSpec &alarm2)
 {
-  uint8_t alrm_en = read_register(PCF85263_ALMEN);
-  if(en)
-  {
-    write_register(PCF85263_ALMEN, (alrm_en | (0x1F)));
-  }
-  else
-  {
-    write_register(PCF85263_ALMEN, (alrm_en & ~(0x1F)));
-  }
-  alrm_en = read_register(PCF85263_ALMEN);
+  uint8_t alrm_en = alarm1.mask & PCF85263_ALMEN_ALARM1;
+  if (alarm2.mask & PCF85263_ALARM_MINUTE) alrm_en |= (1 << 5);
+  if (alarm2.mask & PCF85263_ALARM_HOUR) alrm_en |= (1 << 6);
+  if (alarm2.mask & PCF85263_ALARM_WEEKDAY) alrm_en |= (1 << 7);
   return alrm_en;
 }
 
 /**************************************************************************/
 /*!
-    @brief  Get the current date/time from Timestamp1
-    @return DateTime object containing the current date/time
+    @brief  Get the date/time of the first switch-over to battery (Timestamp2)
+    @return DateTime object containing the recorded date/time
 */
 /**************************************************************************/
 DateTime PCF85263::getTimestampFirstBatSw()
 {
+  PCF85263_STATS_SCOPE(PCF85263_API_TIMESTAMP);
   uint8_t buffer[6];
   buffer[0] = PCF85263_TSTMP2_SECONDS; // start at location 2, VL_SECONDS
-  i2c_dev->write_then_read(buffer, 1, buffer, 6);
+  bus_write_then_read(buffer, 1, buffer, 6);
 
-  return DateTime(bcd2bin(buffer[5]) + 2000U, bcd2bin(buffer[4] & 0x1F),
-                  bcd2bin(buffer[3] & 0x3F), bcd2bin(buffer[2] & 0x3F),
-                  bcd2bin(buffer[1] & 0x7F), bcd2bin(buffer[0] & 0x7F));
+  return decode_timestamp(buffer);
 }
 
 /**************************************************************************/
 /*!
-    @brief  Get the current date/time from Timestamp1
-    @return DateTime object containing the current date/time
+    @brief  Get the date/time of the last switch-over to battery (Timestamp3)
+    @return DateTime object containing the recorded date/time
 */
 /**************************************************************************/
 DateTime PCF85263::getTimestampLastBatSw()
 {
+  PCF85263_STATS_SCOPE(PCF85263_API_TIMESTAMP);
   uint8_t buffer[6];
   buffer[0] = PCF85263_TSTMP3_SECONDS; // start at location 2, VL_SECONDS
-  i2c_dev->write_then_read(buffer, 1, buffer, 6);
+  bus_write_then_read(buffer, 1, buffer, 6);
+
+  return decode_timestamp(buffer);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read all three timestamp registers and the timestamp mode with
+            one 19-byte burst (TSTMP1_SECONDS..TSTMP_Control)
+    @param[out] timestamps Decoded timestamps and raw mode register
+    @return True if the read succeeded, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263::readAllTimestamps(PCF85263_Timestamps &timestamps)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_TIMESTAMP);
+  uint8_t buffer[PCF85263_TSTMP_BURST_LEN];
+  buffer[0] = PCF85263_TSTMP1_SECONDS;
+  if (!bus_write_then_read(buffer, 1, buffer, PCF85263_TSTMP_BURST_LEN))
+    return false;
+
+  timestamps.tsr1 = decode_timestamp(buffer);
+  timestamps.tsr2 = decode_timestamp(buffer + 6);
+  timestamps.tsr3 = decode_timestamp(buffer + 12);
+  timestamps.mode = buffer[18];
+  // The burst also delivered the current mode register
+  refresh_control(PCF85263_TSTMP_Control, buffer[18]);
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Select the events recorded by the three timestamp registers.
+            The mode register is written as a whole, without reading it.
+    @param tsr1 Events of timestamp register 1
+    @param tsr2 Events of timestamp register 2
+    @param tsr3 Events of timestamp register 3
+*/
+/**************************************************************************/
+void PCF85263::setTimestampModes(TSR1Mode tsr1, TSR2Mode tsr2, TSR3Mode tsr3)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_TIMESTAMP);
+  write_control(PCF85263_TSTMP_Control, timestamp_modes(tsr1, tsr2, tsr3));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Events recorded by timestamp register 1
+    @return Mode of TSR1
+*/
+/**************************************************************************/
+PCF85263::TSR1Mode PCF85263::getTSR1Mode(void)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_TIMESTAMP);
+  uint8_t mode = read_control(PCF85263_TSTMP_Control) & 0x03;
+  return mode == 3 ? TSR1_OFF : (TSR1Mode)mode;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Events recorded by timestamp register 2
+    @return Mode of TSR2
+*/
+/**************************************************************************/
+PCF85263::TSR2Mode PCF85263::getTSR2Mode(void)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_TIMESTAMP);
+  uint8_t mode = (read_control(PCF85263_TSTMP_Control) >> 2) & 0x07;
+  return mode > TSR2_LAST_TS ? TSR2_OFF : (TSR2Mode)mode;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Events recorded by timestamp register 3
+    @return Mode of TSR3
+*/
+/**************************************************************************/
+PCF85263::TSR3Mode PCF85263::getTSR3Mode(void)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_TIMESTAMP);
+  return (TSR3Mode)(read_control(PCF85263_TSTMP_Control) >> 6);
+}
 
+/**************************************************************************/
+/*!
+    @brief  Decode the seconds..years registers of a timestamp register
+    @param buffer Register content starting at its seconds register
+    @return DateTime object containing the decoded date/time
+*/
+/**************************************************************************/
+DateTime PCF85263::decode_timestamp(const uint8_t *buffer)
+{
   return DateTime(bcd2bin(buffer[5]) + 2000U, bcd2bin(buffer[4] & 0x1F),
                   bcd2bin(buffer[3] & 0x3F), bcd2bin(buffer[2] & 0x3F),
                   bcd2bin(buffer[1] & 0x7F), bcd2bin(buffer[0] & 0x7F));
 }
 
 
+/**************************************************************************/
+/*!
+    @brief  Build the INTA_enable / INTB_enable value from single flags
+    @return Sources selected by the flags
+*/
+/**************************************************************************/
+IntSources PCF85263::int_sources(bool pulse_mode, bool periodic_int, bool offset_correc_int, bool alarm1_int,
+                                 bool alarm2_int, bool timestamp_int, bool battery_switch_int, bool watchdog_int)
+{
+  return IntSources((uint8_t)((pulse_mode << 7) | (periodic_int << 6) | (offset_correc_int << 5) |
+                              (alarm1_int << 4) | (alarm2_int << 3) | (timestamp_int << 2) |
+                              (battery_switch_int << 1) | (watchdog_int << 0)));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Select the interrupt sources routed to INTA. Every bit of the
+            register is given, so it is written without reading it first.
+*/
+/**************************************************************************/
 void PCF85263::setINTA(bool pulse_mode, bool periodic_int, bool offset_correc_int, bool alarm1_int, bool alarm2_int,
                        bool timestamp_int, bool battery_switch_int, bool watchdog_int)
 {
-  uint8_t intacon = read_register(PCF85263_INTAEN);
-  if(pulse_mode) intacon |= (1 << 7);
-  else intacon &= ~(1 << 7);
-  if(periodic_int) intacon |= (1 << 6);
-  else intacon &= ~(1 << 6);
-  if(offset_correc_int) intacon |= (1 << 5);
-  else intacon &= ~(1 << 5);
-  if(alarm1_int) intacon |= (1 << 4);
-  else intacon &= ~(1 << 4);
-  if(alarm2_int) intacon |= (1 << 3);
-  else intacon &= ~(1 << 3);
-  if(timestamp_int) intacon |= (1 << 2);
-  else intacon &= ~(1 << 2);
-  if(battery_switch_int) intacon |= (1 << 1);
-  else intacon &= ~(1 << 1);
-  if(watchdog_int) intacon |= (1 << 0);
-  else intacon &= ~(1 << 0);
-
-  write_register(PCF85263_INTAEN, intacon);
+  setInterrupts(INT_A, int_sources(pulse_mode, periodic_int, offset_correc_int, alarm1_int, alarm2_int,
+                                   timestamp_int, battery_switch_int, watchdog_int));
 }
 
+/**************************************************************************/
+/*!
+    @brief  Select the interrupt sources routed to INTB. Every bit of the
+            register is given, so it is written without reading it first.
+*/
+/**************************************************************************/
 void PCF85263::setINTB(bool pulse_mode, bool periodic_int, bool offset_correc_int, bool alarm1_int, bool alarm2_int,
                        bool timestamp_int, bool battery_switch_int, bool watchdog_int)
 {
-  uint8_t intbcon = read_register(PCF85263_INTBEN);
-  if(pulse_mode) intbcon |= (1 << 7);
-  else intbcon &= ~(1 << 7);
-  if(periodic_int) intbcon |= (1 << 6);
-  else intbcon &= ~(1 << 6);
-  if(offset_correc_int) intbcon |= (1 << 5);
-  else intbcon &= ~(1 << 5);
-  if(alarm1_int) intbcon |= (1 << 4);
-  else intbcon &= ~(1 << 4);
-  if(alarm2_int) intbcon |= (1 << 3);
-  else intbcon &= ~(1 << 3);
-  if(timestamp_int) intbcon |= (1 << 2);
-  else intbcon &= ~(1 << 2);
-  if(battery_switch_int) intbcon |= (1 << 1);
-  else intbcon &= ~(1 << 1);
-  if(watchdog_int) intbcon |= (1 << 0);
-  else intbcon &= ~(1 << 0);
+  setInterrupts(INT_B, int_sources(pulse_mode, periodic_int, offset_correc_int, alarm1_int, alarm2_int,
+                                   timestamp_int, battery_switch_int, watchdog_int));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Select the interrupt sources routed to one pin. The register is
+            written without reading it first.
+    @param pin INT_A or INT_B
+    @param sources Sources and output mode, e.g.
+        `PCF85263_INT_PULSE | PCF85263_INT_ALARM1`
+*/
+/**************************************************************************/
+void PCF85263::setInterrupts(IntPin pin, IntSources sources)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_INTERRUPT);
+  write_control(pin == INT_B ? PCF85263_INTBEN : PCF85263_INTAEN, sources.bits);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Select the interrupt sources of both pins. Both registers are
+            written in one burst without reading them first; inside a
+            transaction they are written by `commit()`.
+    @param inta Sources and output mode of INTA
+    @param intb Sources and output mode of INTB
+*/
+/**************************************************************************/
+void PCF85263::setInterrupts(IntSources inta, IntSources intb)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_INTERRUPT);
+  if (txn_depth)
+  {
+    write_control(PCF85263_INTAEN, inta.bits);
+    write_control(PCF85263_INTBEN, intb.bits);
+    return;
+  }
+
+  int8_t idx = shadow_index(PCF85263_INTAEN);
+  shadow[idx] = inta.bits;
+  shadow[idx + 1] = intb.bits;
+  shadow_valid |= (3U << idx);
+  uint8_t buffer[3] = {PCF85263_INTAEN, inta.bits, intb.bits};
+  bus_write(buffer, 3);
+}
 
-  write_register(PCF85263_INTBEN, intbcon);
+/**************************************************************************/
+/*!
+    @brief  Get the interrupt sources routed to one pin
+    @param pin INT_A or INT_B
+    @return Sources and output mode of the pin
+*/
+/**************************************************************************/
+IntSources PCF85263::getInterrupts(IntPin pin)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_INTERRUPT);
+  return IntSources(read_control(pin == INT_B ? PCF85263_INTBEN : PCF85263_INTAEN));
 }
 
 
 bool PCF85263::getOffsetMode(void)
 {
-  uint8_t offset_mode = read_register(PCF85263_OSC);
+  PCF85263_STATS_SCOPE(PCF85263_API_OSCILLATOR);
+  uint8_t offset_mode = read_control(PCF85263_OSC);
   return ((offset_mode & 0x40) >> 6);
 }
 
 void PCF85263::setOffsetMode(bool offset_mode)
 {
-  uint8_t offsetmode = read_register(PCF85263_OSC);
+  PCF85263_STATS_SCOPE(PCF85263_API_OSCILLATOR);
+  uint8_t offsetmode = read_control(PCF85263_OSC);
   if(offset_mode)
   {
-    write_register(PCF85263_OSC, (offsetmode | (0x40)));
+    write_control(PCF85263_OSC, (offsetmode | (0x40)));
   }
   else
   {
-    write_register(PCF85263_OSC, (offsetmode & ~(0x40)));
+    write_control(PCF85263_OSC, (offsetmode & ~(0x40)));
   }
 }
 
 int8_t  PCF85263::getOffsetValue(void)
 {
-  int8_t  offset_value = read_register(PCF85263_OFFSET);
+  PCF85263_STATS_SCOPE(PCF85263_API_OSCILLATOR);
+  int8_t  offset_value = read_control(PCF85263_OFFSET);
   return offset_value;
 }
 
 void PCF85263::setOffsetValue(int8_t  offset_value)
 {
-  write_register(PCF85263_OFFSET, offset_value);
+  PCF85263_STATS_SCOPE(PCF85263_API_OSCILLATOR);
+  write_control(PCF85263_OFFSET, offset_value);
 }
 
 void PCF85263::enableLowJitterMode(bool jitter_mode)
 {
-  uint8_t jittermode = read_register(PCF85263_OSC);
+  PCF85263_STATS_SCOPE(PCF85263_API_OSCILLATOR);
+  uint8_t jittermode = read_control(PCF85263_OSC);
   if(jitter_mode)
   {
-    write_register(PCF85263_OSC, (jittermode | (0x10)));
+    write_control(PCF85263_OSC, (jittermode | (0x10)));
   }
   else
   {
-    write_register(PCF85263_OSC, (jittermode & ~(0x10)));
+    write_control(PCF85263_OSC, (jittermode & ~(0x10)));
   }
 }
 
 void PCF85263::setLoadCaps(uint8_t caps)
 {
-  uint8_t capmodes = read_register(PCF85263_OSC);
-  
-  if(caps==0)
+  PCF85263_STATS_SCOPE(PCF85263_API_OSCILLATOR);
+  uint8_t capmodes = read_control(PCF85263_OSC);
+  write_control(PCF85263_OSC, (capmodes & ~(0x03)) | (caps & 0x03));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Configure the watchdog. It expires _period_ steps after the last
+            `kick()` and raises WDF and the watchdog interrupt of INTA/INTB.
+    @param period Steps until expiry, 1 to PCF85263_WD_PERIOD_MAX; 0
+                  disables the watchdog
+    @param stepSize Duration of one step
+    @param repeat True to raise the interrupt on every expiry, false for
+                  only the first one
+*/
+/**************************************************************************/
+void PCF85263::configureWatchdog(uint8_t period, WatchdogStep stepSize, bool repeat)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_WATCHDOG);
+  if (period > PCF85263_WD_PERIOD_MAX)
+    period = PCF85263_WD_PERIOD_MAX;
+  uint8_t wd = (period << 2) | (stepSize & 0x03);
+  if (repeat)
+    wd |= PCF85263_WD_REPEAT;
+  wd_config = period ? wd : 0;
+  write_control(PCF85263_WD, wd);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Restart the watchdog by rewriting register Watchdog. This is a
+            single 2-byte write of the value kept by `configureWatchdog()`,
+            without reading back, and it is not delayed by a transaction,
+            so it is safe to call from an interrupt handler.
+    @note   Call `configureWatchdog()` first; until then, and while the
+            watchdog is disabled, this does nothing.
+    @return True if the write was acknowledged, false if it failed or the
+            watchdog is not configured.
+*/
+/**************************************************************************/
+bool PCF85263::kick(void)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_WATCHDOG);
+  if (wd_config == 0)
+    return false;
+  uint8_t buffer[2] = {PCF85263_WD, wd_config};
+  return bus_write(buffer, 2);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Configure when the device switches from VDD to the backup
+            battery. A battery switch-over raises the battery flag, which
+            can be routed to INTA or INTB with `setInterrupts()`.
+    @param threshold Threshold voltage V_th used by the BSW_AT_VTH,
+        BSW_AT_MAX and BSW_AT_MIN modes
+    @param mode Condition for switching to the battery
+    @param enabled False to disable the battery switch, e.g. if no backup
+        battery is fitted
+    @param fastRefresh True to compare the supply voltages more often, at
+        the cost of a higher current
+*/
+/**************************************************************************/
+void PCF85263::configureBatterySwitch(BatterySwitchThreshold threshold, BatterySwitchMode mode,
+                                      bool enabled, bool fastRefresh)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_POWER);
+  uint8_t batsw = read_control(PCF85263_BATSW);
+  batsw &= ~(0x1F);
+  if (!enabled)
+    batsw |= (1 << 4);
+  if (fastRefresh)
+    batsw |= (1 << 3);
+  batsw |= ((uint8_t)mode & 0x03) << 1;
+  batsw |= (uint8_t)threshold & 0x01;
+  write_control(PCF85263_BATSW, batsw);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Select the frequency on the CLK pin
+    @param frequency CLKOUT_*, CLKOUT_OFF holds the pin low
+*/
+/**************************************************************************/
+void PCF85263::setClockOut(ClockOut frequency)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_POWER);
+  uint8_t funct = read_control(PCF85263_FUNCT);
+  write_control(PCF85263_FUNCT, (funct & ~(0x07)) | ((uint8_t)frequency & 0x07));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Set the rate of the periodic interrupt. Waking once per minute
+            instead of once per second saves 59 of 60 wakeups of the MCU
+            when only the minute matters.
+    @note The interrupt still has to be routed to a pin with
+        `setInterrupts()`. While the software clock of
+        `attachSecondTick()` runs from this device, it follows the new rate
+        and is re-synced; PERIODIC_OFF detaches it.
+    @param rate PERIODIC_*
+*/
+/**************************************************************************/
+void PCF85263::setPeriodicInterrupt(PeriodicRate rate)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_POWER);
+  uint8_t funct = read_control(PCF85263_FUNCT);
+  write_control(PCF85263_FUNCT, (funct & ~(0x60)) | (((uint8_t)rate & 0x03) << 5));
+
+  if (tick_pin < 0)
+    return;
+  if (rate == PERIODIC_OFF)
+  {
+    detachSecondTick();
+    return;
+  }
+  tick_period = tick_seconds(rate);
+  resyncSecondTick();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the rate of the periodic interrupt
+    @return PERIODIC_*
+*/
+/**************************************************************************/
+PCF85263::PeriodicRate PCF85263::getPeriodicInterrupt(void)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_POWER);
+  return (PeriodicRate)((read_control(PCF85263_FUNCT) >> 5) & 0x03);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Select what can stop the clock. With STOP_BY_BIT_OR_TS a level
+            on the TS pin stops the clock like `stop()`, which allows
+            starting it from a hardware signal.
+    @note The TS pin has to be configured as input in the Pin IO register.
+    @param source STOP_BY_BIT or STOP_BY_BIT_OR_TS
+*/
+/**************************************************************************/
+void PCF85263::setStopSource(StopSource source)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_POWER);
+  uint8_t funct = read_control(PCF85263_FUNCT);
+  if (source == STOP_BY_BIT_OR_TS)
+    write_control(PCF85263_FUNCT, funct | (0x08));
+  else
+    write_control(PCF85263_FUNCT, funct & ~(0x08));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Keep a software clock running from the periodic interrupt.
+    The periodic interrupt is set to _rate_ and routed to INTA in pulse
+    mode, the time is read once and every falling edge on _pin_ then
+    advances the software clock without any bus traffic. `tickNow()` reads
+    that clock.
+    With PERIODIC_MINUTE or PERIODIC_HOUR the MCU wakes 60 or 3600 times
+    less often, but `tickNow()` has the resolution of one tick: after the
+    first tick it returns the start of the current minute or hour.
+    @note Only one PCF85263 instance can drive the software clock at a
+        time; attaching a second one detaches the first.
+    @param pin MCU pin connected to INTA, must support external interrupts
+    @param resync_ticks Number of ticks after which `tickNow()` reads the
+        device again to cancel missed edges, 0 to never re-sync
+        automatically
+    @param rate PERIODIC_SECOND, PERIODIC_MINUTE or PERIODIC_HOUR
+    @return True if the time could be read, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263::attachSecondTick(uint8_t pin, uint32_t resync_ticks, PeriodicRate rate)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_SECOND_TICK);
+  if (tick_instance)
+    tick_instance->detachSecondTick();
+
+  if (rate == PERIODIC_OFF)
+    rate = PERIODIC_SECOND;
+  tick_period = tick_seconds(rate);
+
+  beginTransaction();
+  uint8_t funct = read_control(PCF85263_FUNCT);
+  write_control(PCF85263_FUNCT, (funct & ~(0x60)) | ((uint8_t)rate << 5));
+  // INTA pin used as interrupt output
+  uint8_t pinio = read_control(PCF85263_PINIO);
+  write_control(PCF85263_PINIO, (pinio & ~(0x03)) | (0x02));
+  // Pulse mode and periodic interrupt on INTA
+  uint8_t intacon = read_control(PCF85263_INTAEN);
+  write_control(PCF85263_INTAEN, intacon | (PCF85263_INT_PULSE | PCF85263_INT_PERIODIC).bits);
+  commit();
+
+  tick_resync = resync_ticks;
+  tick_pin = pin;
+  tick_instance = this;
+  pinMode(pin, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(pin), second_tick_isr, FALLING);
+  return resyncSecondTick();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Stop advancing the software clock. The periodic interrupt of
+            the device is left enabled.
+*/
+/**************************************************************************/
+void PCF85263::detachSecondTick(void)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_SECOND_TICK);
+  if (tick_pin < 0)
+    return;
+  detachInterrupt(digitalPinToInterrupt(tick_pin));
+  tick_pin = -1;
+  if (tick_instance == this)
+    tick_instance = NULL;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Re-read the time from the device and restart the software
+            clock from it. If an edge arrives while the time is read, it is
+            unclear whether the read saw the new second, so the read is
+            repeated once.
+    @return True if the software clock is attached and the time could be
+            read, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263::resyncSecondTick(void)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_SECOND_TICK);
+  if (tick_pin < 0)
+    return false;
+  for (uint8_t tries = 0; tries < 2; tries++)
   {
-    write_register(PCF85263_OSC, (capmodes & ~(0x03)));
+    noInterrupts();
+    tick_count = 0;
+    interrupts();
+    tick_time = now();
+    tick_applied = 0;
+    noInterrupts();
+    uint32_t ticks = tick_count;
+    interrupts();
+    if (ticks == 0)
+      break;
   }
-  else if(caps==1)
+  return tick_time.isValid();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the current date/time from the software clock. This is a
+            memory read, except every _resync_ticks_ ticks when the device
+            is read again.
+    @return DateTime object containing the current date/time, or `now()`
+            if no software clock is attached.
+*/
+/**************************************************************************/
+DateTime PCF85263::tickNow(void)
+{
+  PCF85263_STATS_SCOPE(PCF85263_API_SECOND_TICK);
+  if (tick_pin < 0)
+    return now();
+  noInterrupts();
+  uint32_t ticks = tick_count;
+  interrupts();
+  if (tick_resync && ticks >= tick_resync)
   {
-    write_register(PCF85263_OSC, (capmodes & ~(0x03)));
-    write_register(PCF85263_OSC, (capmodes | (0x01)));
+    resyncSecondTick();
+    noInterrupts();
+    ticks = tick_count;
+    interrupts();
   }
-  else
+  if (ticks != tick_applied)
   {
-    write_register(PCF85263_OSC, (capmodes | (0x03)));
+    // Each tick lands on the start of a minute or hour, drop the part of
+    // the period that had already passed when the clock was read
+    uint32_t elapsed = tick_time.secondstime() % tick_period;
+    tick_time.advance((ticks - tick_applied) * tick_period - elapsed);
+    tick_applied = ticks;
   }
-}
\ No newline at end of file
+  return tick_time;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Length of one periodic interrupt period
+    @param rate PERIODIC_SECOND, PERIODIC_MINUTE or PERIODIC_HOUR
+    @return Seconds per tick
+*/
+/**************************************************************************/
+uint16_t PCF85263::tick_seconds(PeriodicRate rate)
+{
+  return rate == PERIODIC_HOUR ? 3600 : rate == PERIODIC_MINUTE ? 60 : 1;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Interrupt handler of the periodic interrupt on INTA
+*/
+/**************************************************************************/
+void PCF85263::second_tick_isr(void)
+{
+  if (tick_instance)
+    tick_instance->tick_count++;
+}
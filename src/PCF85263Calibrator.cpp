@@ -0,0 +1,157 @@
+/**************************************************************************/
+/*!
+    @file     PCF85263Calibrator.cpp
+    Computes and applies the frequency offset of a PCF85263 from its drift
+    against an external time reference.
+    Written by Fabian Voelker for promesstec GmbH.
+    MIT license, all text here must be included in any redistribution.
+*/
+/**************************************************************************/
+
+
+#include "PCF85263Calibrator.h"
+
+/**************************************************************************/
+/*!
+    @brief  Attach the calibrator to a device
+    @param rtc Started device, must outlive the calibrator
+    @param maxStep Largest offset change per `apply()`, at least 1
+*/
+/**************************************************************************/
+void PCF85263Calibrator::begin(PCF85263 &rtc, uint8_t maxStep)
+{
+  this->rtc = &rtc;
+  max_step = maxStep ? maxStep : 1;
+  started = false;
+  measured = false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Start a measurement window
+    @param reference_ms Reference time in milliseconds at this instant
+    @return True if the window started, false if the device could not be
+            read.
+*/
+/**************************************************************************/
+bool PCF85263Calibrator::start(uint32_t reference_ms)
+{
+  DateTimeMs now = rtc->nowPrecise();
+  measured = false;
+  started = now.isValid();
+  if (started) {
+    start_rtc_ms = rtc_ms(now);
+    start_ref_ms = reference_ms;
+  }
+  return started;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Compute the drift since `start()`
+    @param reference_ms Reference time in milliseconds at this instant
+    @return True if a drift could be computed, false if no window was
+            started or no reference time has passed. If the device could
+            not be read the sample is dropped and a new window starts.
+*/
+/**************************************************************************/
+bool PCF85263Calibrator::measure(uint32_t reference_ms)
+{
+  if (!started)
+    return false;
+  DateTimeMs now = rtc->nowPrecise();
+  if (!now.isValid()) {
+    start(reference_ms);
+    return false;
+  }
+  int64_t rtc_elapsed = (int64_t)(rtc_ms(now) - start_rtc_ms);
+  int64_t ref_elapsed = (uint32_t)(reference_ms - start_ref_ms);
+  if (ref_elapsed <= 0)
+    return false;
+
+  int64_t error = (rtc_elapsed - ref_elapsed) * 1000000000LL;
+  // round to nearest
+  error += (error >= 0) ? ref_elapsed / 2 : -(ref_elapsed / 2);
+  int64_t ppb = error / ref_elapsed;
+  if (ppb > 2147483647LL) ppb = 2147483647LL;
+  if (ppb < -2147483647LL) ppb = -2147483647LL;
+  drift_ppb = (int32_t)ppb;
+  measured = true;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Offset register value that cancels the measured drift
+    @param offset_mode PCF85263_OFFSETMODE_NORMAL or PCF85263_OFFSETMODE_FAST
+    @return Offset value for the given mode, the current value if nothing
+            was measured
+*/
+/**************************************************************************/
+int8_t PCF85263Calibrator::correction(uint8_t offset_mode) const
+{
+  return correction(rtc->getOffsetValue(), offset_mode);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Offset register value that cancels the measured drift
+    @param current Offset value in effect during the measurement
+    @param offset_mode PCF85263_OFFSETMODE_NORMAL or PCF85263_OFFSETMODE_FAST
+    @return Offset value for the given mode, _current_ if nothing was
+            measured
+*/
+/**************************************************************************/
+int8_t PCF85263Calibrator::correction(int16_t current, uint8_t offset_mode) const
+{
+  if (!measured)
+    return current;
+
+  int32_t step = (offset_mode == PCF85263_OFFSETMODE_FAST) ? PCF85263_OFFSET_STEP_FAST_PPB
+                                                            : PCF85263_OFFSET_STEP_NORMAL_PPB;
+  int32_t lsb = (drift_ppb >= 0) ? (drift_ppb + step / 2) / step : -((-drift_ppb + step / 2) / step);
+  int32_t target = current - lsb;
+  if (target > 127) target = 127;
+  if (target < -128) target = -128;
+  return target;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Move the offset register towards `correction()` for the mode
+            the device is in, by at most _maxStep_ LSB, and start a new
+            measurement window
+    @param reference_ms Reference time in milliseconds at this instant
+    @return True if the offset now cancels the measured drift, false if
+            further `measure()`/`apply()` rounds are needed.
+*/
+/**************************************************************************/
+bool PCF85263Calibrator::apply(uint32_t reference_ms)
+{
+  if (!measured)
+    return false;
+
+  int16_t current = rtc->getOffsetValue();
+  int16_t target = correction(current, rtc->getOffsetMode() ? PCF85263_OFFSETMODE_FAST
+                                                            : PCF85263_OFFSETMODE_NORMAL);
+  int16_t delta = target - current;
+  if (delta > max_step) delta = max_step;
+  if (delta < -max_step) delta = -max_step;
+  if (delta)
+    rtc->setOffsetValue(current + delta);
+
+  start(reference_ms);
+  return current + delta == target;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Device time in milliseconds since 2000-01-01
+    @param dt Time read with `nowPrecise()`
+    @return Milliseconds, with 10 ms resolution
+*/
+/**************************************************************************/
+uint64_t PCF85263Calibrator::rtc_ms(const DateTimeMs &dt)
+{
+  return (uint64_t)dt.secondstime() * 1000U + dt.millisecond();
+}
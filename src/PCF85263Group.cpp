@@ -0,0 +1,85 @@
+/**************************************************************************/
+/*!
+    @file     PCF85263Group.cpp
+    Reads several PCF85263 on separate I2C buses as close to the same
+    instant as possible.
+    Written by Fabian Voelker for promesstec GmbH.
+    MIT license, all text here must be included in any redistribution.
+*/
+/**************************************************************************/
+
+
+#include "PCF85263Group.h"
+
+/**************************************************************************/
+/*!
+    @brief  Add a device to the group
+    @param rtc Started device, must outlive the group
+    @return True if added, false if the group is full.
+*/
+/**************************************************************************/
+bool PCF85263Group::add(PCF85263 &rtc)
+{
+  if (count >= PCF85263_GROUP_MAX_DEVICES)
+    return false;
+  devices[count++] = &rtc;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read the time of all devices at (nearly) the same instant
+    @param[out] times Array of `size()` entries receiving the times
+    @param[out] valid Optional array of `size()` entries, set to true for
+                every device that could be read
+    @return Number of devices read successfully
+*/
+/**************************************************************************/
+uint8_t PCF85263Group::readAll(DateTimeMs *times, bool *valid)
+{
+  bool started[PCF85263_GROUP_MAX_DEVICES];
+
+  // Nothing may still be in flight when the reads are started
+  for (uint8_t i = 0; i < count; i++)
+    while (devices[i]->poll() == PCF85263_XFER_BUSY)
+      ;
+
+  for (uint8_t i = 0; i < count; i++)
+    started[i] = devices[i]->requestRead(PCF85263_100TH_SECONDS, buffers[i],
+                                         PCF85263_GROUP_READ_LEN);
+
+  uint8_t ok = 0;
+  int32_t earliest = 0, latest = 0;
+  uint32_t reference = 0;
+  uint8_t reference_cs = 0;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    uint8_t status = PCF85263_XFER_ERROR;
+    if (started[i])
+      while ((status = devices[i]->poll()) == PCF85263_XFER_BUSY)
+        ;
+    if (valid)
+      valid[i] = status == PCF85263_XFER_DONE;
+    if (status != PCF85263_XFER_DONE)
+      continue;
+
+    times[i] = DateTimeMs(PCF85263::decode_time(buffers[i] + 1),
+                          PCF85263::bcd2bin(buffers[i][0]));
+
+    // Offset to the first device read, in hundredths
+    if (ok == 0)
+    {
+      reference = times[i].unixtime();
+      reference_cs = times[i].hundredth();
+    }
+    int32_t offset = (int32_t)(times[i].unixtime() - reference) * 100 +
+                     times[i].hundredth() - reference_cs;
+    if (ok == 0 || offset < earliest)
+      earliest = offset;
+    if (ok == 0 || offset > latest)
+      latest = offset;
+    ++ok;
+  }
+  last_spread = latest - earliest;
+  return ok;
+}
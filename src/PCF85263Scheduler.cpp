@@ -0,0 +1,318 @@
+/**************************************************************************/
+/*!
+    @file     PCF85263Scheduler.cpp
+    Runs many logical timers on the two hardware alarms of a PCF85263.
+    Written by Fabian Voelker for promesstec GmbH.
+    MIT license, all text here must be included in any redistribution.
+*/
+/**************************************************************************/
+
+
+#include "PCF85263Scheduler.h"
+
+/**************************************************************************/
+/*!
+    @brief  Attach the scheduler to a device and disable both alarms
+    @param rtc Started device, must outlive the scheduler
+*/
+/**************************************************************************/
+void PCF85263Scheduler::begin(PCF85263 &rtc)
+{
+  this->rtc = &rtc;
+  count = 0;
+  fired = false;
+  rtc.setAlarms(AlarmSpec::never(), AlarmSpec::never());
+  rtc.clearFlags(PCF85263_FLAG_ALARM1 | PCF85263_FLAG_ALARM2);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Add a periodic job, first due one period from now
+    @param period Time between runs, at least one second
+    @param callback Function to dispatch
+    @return Job id, or PCF85263_SCHEDULER_NO_JOB if the scheduler is full
+            or the time could not be read
+*/
+/**************************************************************************/
+uint8_t PCF85263Scheduler::every(const TimeSpan &period, PCF85263_JobCallback callback)
+{
+  if (period.totalseconds() <= 0)
+    return PCF85263_SCHEDULER_NO_JOB;
+  DateTime now_dt = rtc->now();
+  if (!now_dt.isValid())
+    return PCF85263_SCHEDULER_NO_JOB;
+  PackedDateTime now(now_dt);
+  return add(now + period, (uint32_t)period.totalseconds(), callback, now);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Add a one-shot job. A job that is already due runs on the
+            next `service()`.
+    @param when Time the job is due, must lie within the next year
+    @param callback Function to dispatch
+    @return Job id, or PCF85263_SCHEDULER_NO_JOB if the scheduler is full
+            or the time could not be read
+*/
+/**************************************************************************/
+uint8_t PCF85263Scheduler::at(const DateTime &when, PCF85263_JobCallback callback)
+{
+  DateTime now_dt = rtc->now();
+  if (!now_dt.isValid())
+    return PCF85263_SCHEDULER_NO_JOB;
+  PackedDateTime now(now_dt);
+  PackedDateTime deadline(when);
+  uint8_t id = add(deadline, 0, callback, now);
+  if (id != PCF85263_SCHEDULER_NO_JOB && deadline <= now)
+    fired = true;
+  return id;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Remove a job
+    @param job Id returned by `every()` or `at()`
+    @return True if the job was scheduled, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263Scheduler::cancel(uint8_t job)
+{
+  for (uint8_t i = 0; i < count; i++) {
+    if (heap[i].id == job) {
+      remove(i);
+      if (i == 0)
+        arm();
+      return true;
+    }
+  }
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the nearest deadline
+    @param[out] when Time the next job is due
+    @return True if a job is scheduled, false otherwise.
+*/
+/**************************************************************************/
+bool PCF85263Scheduler::next(DateTime &when) const
+{
+  if (count == 0)
+    return false;
+  when = heap[0].deadline.toDateTime();
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Dispatch all due jobs and program the next deadline. Periodic
+            jobs that missed several runs are run once and rescheduled on
+            their original grid. If the time cannot be read nothing is
+            dispatched, the alarms stay as they are and the next call
+            tries again.
+    @param force Also run if `isr()` was not called, e.g. when polling
+    @return Number of callbacks dispatched
+*/
+/**************************************************************************/
+uint8_t PCF85263Scheduler::service(bool force)
+{
+  if (!fired && !force)
+    return 0;
+  fired = false;
+  rtc->clearFlags(PCF85263_FLAG_ALARM1 | PCF85263_FLAG_ALARM2);
+
+  uint8_t dispatched = 0;
+  DateTime now_dt = rtc->now();
+  if (!now_dt.isValid()) {
+    fired = true;
+    return 0;
+  }
+  PackedDateTime now(now_dt);
+  while (count > 0 && heap[0].deadline <= now) {
+    Job job = heap[0];
+    remove(0);
+    if (job.period) {
+      uint32_t late = now.secondstime() - job.deadline.secondstime();
+      job.deadline = PackedDateTime(job.deadline.secondstime() + (late / job.period + 1) * job.period);
+      push(job);
+    }
+    job.callback(job.id, now_dt);
+    dispatched++;
+
+    // callbacks take time, catch deadlines that passed meanwhile
+    if (count > 0 && !(now < heap[0].deadline)) {
+      DateTime later = rtc->now();
+      if (!later.isValid()) {
+        fired = true;
+        break;
+      }
+      now_dt = later;
+      now = PackedDateTime(now_dt);
+    }
+  }
+  arm(now);
+  return dispatched;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Insert a job with a fresh id
+    @param deadline First time the job is due
+    @param period Seconds between runs, 0 for one-shot jobs
+    @param callback Function to dispatch
+    @param now Current time, to arm the alarms from
+    @return Job id, or PCF85263_SCHEDULER_NO_JOB if the scheduler is full
+*/
+/**************************************************************************/
+uint8_t PCF85263Scheduler::add(const PackedDateTime &deadline, uint32_t period, PCF85263_JobCallback callback,
+                               const PackedDateTime &now)
+{
+  if (count >= PCF85263_SCHEDULER_MAX_JOBS || callback == NULL)
+    return PCF85263_SCHEDULER_NO_JOB;
+
+  while (id_used(next_id) || next_id == PCF85263_SCHEDULER_NO_JOB)
+    next_id++;
+
+  Job job;
+  job.deadline = deadline;
+  job.period = period;
+  job.callback = callback;
+  job.id = next_id++;
+  push(job);
+  if (heap[0].id == job.id)
+    arm(now);
+  return job.id;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Insert a job into the heap, the caller checks the capacity
+    @param job Job to insert
+*/
+/**************************************************************************/
+void PCF85263Scheduler::push(const Job &job)
+{
+  heap[count] = job;
+  sift_up(count++);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Remove the job at a heap position
+    @param index Heap position
+*/
+/**************************************************************************/
+void PCF85263Scheduler::remove(uint8_t index)
+{
+  count--;
+  if (index == count)
+    return;
+  heap[index] = heap[count];
+  sift_up(index);
+  sift_down(index);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Move a job towards the root until its parent is not later
+    @param index Heap position
+*/
+/**************************************************************************/
+void PCF85263Scheduler::sift_up(uint8_t index)
+{
+  while (index > 0) {
+    uint8_t parent = (index - 1) / 2;
+    if (!(heap[index].deadline < heap[parent].deadline))
+      break;
+    Job tmp = heap[index];
+    heap[index] = heap[parent];
+    heap[parent] = tmp;
+    index = parent;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Move a job towards the leaves until no child is earlier
+    @param index Heap position
+*/
+/**************************************************************************/
+void PCF85263Scheduler::sift_down(uint8_t index)
+{
+  while (true) {
+    uint8_t earliest = index;
+    uint8_t child = 2 * index + 1;
+    if (child < count && heap[child].deadline < heap[earliest].deadline)
+      earliest = child;
+    child++;
+    if (child < count && heap[child].deadline < heap[earliest].deadline)
+      earliest = child;
+    if (earliest == index)
+      break;
+    Job tmp = heap[index];
+    heap[index] = heap[earliest];
+    heap[earliest] = tmp;
+    index = earliest;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Test if an id belongs to a scheduled job
+    @param id Job id
+    @return True if the id is in use
+*/
+/**************************************************************************/
+bool PCF85263Scheduler::id_used(uint8_t id) const
+{
+  for (uint8_t i = 0; i < count; i++)
+    if (heap[i].id == id)
+      return true;
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Program the alarms for the nearest deadline, reading the
+            current time from the device. If that read fails the alarms
+            are left as they are.
+*/
+/**************************************************************************/
+void PCF85263Scheduler::arm()
+{
+  if (rtc == NULL)
+    return;
+  if (count == 0) {
+    rtc->setAlarms(AlarmSpec::never(), AlarmSpec::never());
+    return;
+  }
+  DateTime now = rtc->now();
+  if (now.isValid())
+    arm(PackedDateTime(now));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Program the nearest deadline into Alarm1 and the full minute
+            after it into Alarm2, both with one burst. Alarm2 only matches
+            weekday, hour and minute, so for a deadline that has already
+            passed it is set to the full minute after _now_ instead;
+            otherwise the backup would wait up to a week.
+    @param now Current time
+*/
+/**************************************************************************/
+void PCF85263Scheduler::arm(const PackedDateTime &now)
+{
+  if (rtc == NULL)
+    return;
+  if (count == 0) {
+    rtc->setAlarms(AlarmSpec::never(), AlarmSpec::never());
+    return;
+  }
+
+  PackedDateTime base = now < heap[0].deadline ? heap[0].deadline : now;
+  PackedDateTime backup = base + TimeSpan(60 - base.secondstime() % 60);
+  DateTime backup_dt = backup.toDateTime();
+  rtc->setAlarms(AlarmSpec::at(heap[0].deadline.toDateTime()),
+                 AlarmSpec::weeklyAt(backup_dt.dayOfTheWeek(), backup_dt.hour(), backup_dt.minute()));
+}
@@ -0,0 +1,251 @@
+/**************************************************************************/
+/*!
+    @file     PCF85263Sim.cpp
+    Register-level simulation of a PCF85263 behind the transport interface,
+    to run and measure the driver without hardware.
+    Written by Fabian Voelker for promesstec GmbH.
+    MIT license, all text here must be included in any redistribution.
+*/
+/**************************************************************************/
+
+
+#include "PCF85263Sim.h"
+
+/**************************************************************************/
+/*!
+    @brief  Write registers, applying the side effects of the device: flags
+            can only be cleared, RESETS runs a command, the rest is stored
+    @param buffer Register address followed by the data
+    @param len Number of bytes in buffer
+    @return True unless the device is marked as missing.
+*/
+/**************************************************************************/
+bool PCF85263_SimTransport::write(const uint8_t *buffer, size_t len) {
+  ++transactions;
+  bytes_written += len;
+  error = present ? PCF85263_ERR_NONE : PCF85263_ERR_NACK_ADDR;
+  if (!present || len == 0)
+    return present;
+  pointer = buffer[0] % PCF85263_REGISTER_COUNT;
+  for (size_t i = 1; i < len; i++) {
+    uint8_t value = buffer[i];
+    if (pointer == PCF85263_FLAGS) {
+      registers[pointer] &= value;
+    } else if (pointer == PCF85263_RESETS) {
+      if (value == PCF85263_SIM_RESET_SOFTWARE) {
+        powerOn();
+      } else if (value == PCF85263_SIM_RESET_PRESCALER) {
+        registers[PCF85263_100TH_SECONDS] = 0;
+      } else if (value == PCF85263_SIM_RESET_TIMESTAMP) {
+        memset(registers + PCF85263_TSTMP1_SECONDS, 0,
+               PCF85263_TSTMP_Control - PCF85263_TSTMP1_SECONDS);
+      }
+    } else {
+      registers[pointer] = value;
+    }
+    pointer = (pointer + 1) % PCF85263_REGISTER_COUNT;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Bring the registers to their power-on state: everything cleared
+            except the OS bit, which marks the time as invalid. The traffic
+            counters are kept.
+*/
+/**************************************************************************/
+void PCF85263_SimTransport::powerOn(void) {
+  memset(registers, 0, sizeof(registers));
+  registers[PCF85263_SECOND] = 0x80;
+  registers[PCF85263_DAY] = 0x01;
+  registers[PCF85263_MONTH] = 0x01;
+  pointer = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Let time pass. Nothing counts while the STOP bit is set; the
+            hundredths register always counts in the simulation, the
+            100TH bit only affects the real device's output.
+    @param hundredths Time to advance by in 1/100 s
+*/
+/**************************************************************************/
+void PCF85263_SimTransport::advance(uint32_t hundredths) {
+  if (registers[PCF85263_STOPEN] & 0x01)
+    return;
+  while (hundredths--) {
+    if (inc_bcd(registers[PCF85263_100TH_SECONDS], 0x00, 0x99))
+      tick_second();
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Simulate an event on the TS pin
+*/
+/**************************************************************************/
+void PCF85263_SimTransport::triggerTimestamp(void) {
+  uint8_t mode = registers[PCF85263_TSTMP_Control];
+  uint8_t tsr1 = mode & 0x03;
+  uint8_t tsr2 = (mode >> 2) & 0x07;
+  uint8_t flags = registers[PCF85263_FLAGS];
+
+  if ((tsr1 == 1 && !(flags & PCF85263_FLAG_TSR1)) || tsr1 == 2)
+    record(PCF85263_TSTMP1_SECONDS);
+  if (tsr1)
+    registers[PCF85263_FLAGS] |= PCF85263_FLAG_TSR1;
+
+  if ((tsr2 == 4 && !(flags & PCF85263_FLAG_TSR2)) || tsr2 == 5) {
+    record(PCF85263_TSTMP2_SECONDS);
+    registers[PCF85263_FLAGS] |= PCF85263_FLAG_TSR2;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Simulate a switch-over between VDD and the battery
+    @param on_battery True for VDD to battery, false for battery to VDD
+*/
+/**************************************************************************/
+void PCF85263_SimTransport::switchSupply(bool on_battery) {
+  if (on_battery == battery)
+    return;
+  battery = on_battery;
+
+  uint8_t mode = registers[PCF85263_TSTMP_Control];
+  uint8_t tsr2 = (mode >> 2) & 0x07;
+  uint8_t tsr3 = (mode >> 6) & 0x03;
+  uint8_t flags = registers[PCF85263_FLAGS];
+
+  if (on_battery) {
+    registers[PCF85263_FLAGS] |= PCF85263_FLAG_BATTERY;
+    if ((tsr2 == 1 && !(flags & PCF85263_FLAG_TSR2)) || tsr2 == 2) {
+      record(PCF85263_TSTMP2_SECONDS);
+      registers[PCF85263_FLAGS] |= PCF85263_FLAG_TSR2;
+    }
+    if ((tsr3 == 1 && !(flags & PCF85263_FLAG_TSR3)) || tsr3 == 2) {
+      record(PCF85263_TSTMP3_SECONDS);
+      registers[PCF85263_FLAGS] |= PCF85263_FLAG_TSR3;
+    }
+  } else {
+    if (tsr2 == 3) {
+      record(PCF85263_TSTMP2_SECONDS);
+      registers[PCF85263_FLAGS] |= PCF85263_FLAG_TSR2;
+    }
+    if (tsr3 == 3) {
+      record(PCF85263_TSTMP3_SECONDS);
+      registers[PCF85263_FLAGS] |= PCF85263_FLAG_TSR3;
+    }
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Carry one second into the time registers, or into the stopwatch
+            counters when RTCM is set in register Function
+*/
+/**************************************************************************/
+void PCF85263_SimTransport::tick_second(void) {
+  uint8_t *r = registers;
+  uint8_t os = r[PCF85263_SECOND] & 0x80;
+  r[PCF85263_SECOND] &= 0x7F;
+  bool carry = inc_bcd(r[PCF85263_SECOND], 0x00, 0x59);
+  r[PCF85263_SECOND] |= os;
+  if (carry)
+    carry = inc_bcd(r[PCF85263_MINUTE], 0x00, 0x59);
+  if (!carry) {
+    check_alarms();
+    return;
+  }
+
+  if (r[PCF85263_FUNCT] & 0x10) {
+    // stopwatch: six BCD hour digits, least significant register first
+    if (inc_bcd(r[PCF85263_SW_HOURS_XX_XX_00], 0x00, 0x99) &&
+        inc_bcd(r[PCF85263_SW_HOURS_XX_00_XX], 0x00, 0x99))
+      inc_bcd(r[PCF85263_SW_HOURS_00_XX_XX], 0x00, 0x99);
+    return;
+  }
+
+  if (inc_bcd(r[PCF85263_HOUR], 0x00, 0x23)) {
+    r[PCF85263_WEEKDAY] = (r[PCF85263_WEEKDAY] + 1) % 7;
+    uint8_t year = (r[PCF85263_YEAR] >> 4) * 10 + (r[PCF85263_YEAR] & 0x0F);
+    uint8_t month = (r[PCF85263_MONTH] >> 4) * 10 + (r[PCF85263_MONTH] & 0x0F);
+    uint8_t last = 0x31;
+    if (month == 4 || month == 6 || month == 9 || month == 11)
+      last = 0x30;
+    else if (month == 2)
+      last = (year % 4 == 0) ? 0x29 : 0x28;
+    if (inc_bcd(r[PCF85263_DAY], 0x01, last) &&
+        inc_bcd(r[PCF85263_MONTH], 0x01, 0x12))
+      inc_bcd(r[PCF85263_YEAR], 0x00, 0x99);
+  }
+  check_alarms();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Raise A1F/A2F if all enabled fields of an alarm match the time
+*/
+/**************************************************************************/
+void PCF85263_SimTransport::check_alarms(void) {
+  const uint8_t *r = registers;
+  if (r[PCF85263_FUNCT] & 0x10)
+    return;
+  uint8_t en = r[PCF85263_ALMEN];
+
+  if (en & PCF85263_ALMEN_ALARM1) {
+    const uint8_t now[5] = {(uint8_t)(r[PCF85263_SECOND] & 0x7F), r[PCF85263_MINUTE],
+                            r[PCF85263_HOUR], r[PCF85263_DAY], r[PCF85263_MONTH]};
+    bool match = true;
+    for (uint8_t i = 0; i < 5; i++)
+      if ((en & (1 << i)) && r[PCF85263_ALM1_SECONDS + i] != now[i])
+        match = false;
+    if (match)
+      registers[PCF85263_FLAGS] |= PCF85263_FLAG_ALARM1;
+  }
+
+  // Alarm2 only compares whole minutes
+  if ((en & PCF85263_ALMEN_ALARM2) && (r[PCF85263_SECOND] & 0x7F) == 0) {
+    const uint8_t now[3] = {r[PCF85263_MINUTE], r[PCF85263_HOUR], r[PCF85263_WEEKDAY]};
+    bool match = true;
+    for (uint8_t i = 0; i < 3; i++)
+      if ((en & (1 << (i + 5))) && r[PCF85263_ALM2_MINUTE + i] != now[i])
+        match = false;
+    if (match)
+      registers[PCF85263_FLAGS] |= PCF85263_FLAG_ALARM2;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Copy seconds..years into a timestamp register
+    @param reg First register of the timestamp, TSTMPn_SECONDS
+*/
+/**************************************************************************/
+void PCF85263_SimTransport::record(uint8_t reg) {
+  registers[reg + 0] = registers[PCF85263_SECOND] & 0x7F;
+  registers[reg + 1] = registers[PCF85263_MINUTE];
+  registers[reg + 2] = registers[PCF85263_HOUR];
+  registers[reg + 3] = registers[PCF85263_DAY];
+  registers[reg + 4] = registers[PCF85263_MONTH];
+  registers[reg + 5] = registers[PCF85263_YEAR];
+}
+
+/**************************************************************************/
+/*!
+    @brief  Increment a BCD register, wrapping from _last_ to _first_
+    @param value Register content
+    @param first Value after the wrap
+    @param last Largest value
+    @return True if the register wrapped, i.e. carries into the next one
+*/
+/**************************************************************************/
+bool PCF85263_SimTransport::inc_bcd(uint8_t &value, uint8_t first, uint8_t last) {
+  if (value >= last) {
+    value = first;
+    return true;
+  }
+  value = ((value & 0x0F) == 9) ? (uint8_t)((value & 0xF0) + 0x10) : (uint8_t)(value + 1);
+  return false;
+}
@@ -0,0 +1,15 @@
+/* Adafruit BusIO device without a bus */
+#ifndef __PCF85263_SHIM_ADAFRUIT_I2CDEVICE_H__
+#define __PCF85263_SHIM_ADAFRUIT_I2CDEVICE_H__
+
+#include "Wire.h"
+
+class Adafruit_I2CDevice {
+public:
+  Adafruit_I2CDevice(uint8_t, TwoWire * = &Wire) {}
+  bool begin(bool = true) { return false; }
+  bool write(const uint8_t *, size_t, bool = true, const uint8_t * = NULL, size_t = 0) { return false; }
+  bool write_then_read(const uint8_t *, size_t, uint8_t *, size_t, bool = false) { return false; }
+};
+
+#endif
@@ -0,0 +1,57 @@
+/* Minimal Arduino API for building the library natively in `pio test -e native` */
+#ifndef __PCF85263_SHIM_ARDUINO_H__
+#define __PCF85263_SHIM_ARDUINO_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define memcpy_P memcpy
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+class String {
+public:
+  String(const char *str = "") : s(str) {}
+  const char *c_str() const { return s.c_str(); }
+  size_t length() const { return s.length(); }
+  bool operator==(const char *str) const { return s == str; }
+
+private:
+  std::string s;
+};
+
+#define INPUT 0x0
+#define INPUT_PULLUP 0x2
+#define FALLING 2
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+/* Handler of the last attachInterrupt(), tests call it to simulate an edge */
+typedef void (*ShimInterruptHandler)(void);
+inline ShimInterruptHandler &shimInterruptHandler(void)
+{
+  static ShimInterruptHandler handler = NULL;
+  return handler;
+}
+inline void attachInterrupt(int, void (*isr)(void), int) { shimInterruptHandler() = isr; }
+inline void detachInterrupt(int) { shimInterruptHandler() = NULL; }
+inline void noInterrupts(void) {}
+inline void interrupts(void) {}
+
+inline uint32_t micros(void)
+{
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline uint32_t millis(void) { return micros() / 1000; }
+inline void delay(uint32_t) {}
+
+#endif
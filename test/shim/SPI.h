@@ -0,0 +1 @@
+/* Unused by the library, included by PCF85263.h for Adafruit BusIO */
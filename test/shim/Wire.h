@@ -0,0 +1,21 @@
+/* TwoWire without a bus, every transfer is not acknowledged */
+#ifndef __PCF85263_SHIM_WIRE_H__
+#define __PCF85263_SHIM_WIRE_H__
+
+#include "Arduino.h"
+
+class TwoWire {
+public:
+  void begin(void) {}
+  void beginTransmission(uint8_t) {}
+  uint8_t endTransmission(bool = true) { return 2; }
+  size_t write(uint8_t) { return 1; }
+  size_t write(const uint8_t *, size_t len) { return len; }
+  uint8_t requestFrom(uint8_t, uint8_t, uint8_t = 1) { return 0; }
+  int available(void) { return 0; }
+  int read(void) { return -1; }
+};
+
+static TwoWire Wire;
+
+#endif
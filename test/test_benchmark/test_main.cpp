@@ -0,0 +1,170 @@
+// Timing of the DateTime/TimeSpan hot paths, one CSV line per benchmark:
+// name,iterations,unit,total,per_op
+// pio test -e native reports host nanoseconds, pio test -e
+// genericSTM32F103RE CPU cycles from DWT CYCCNT.
+#include <unity.h>
+#include <stdio.h>
+#include <PCF85263.h>
+
+#if defined(ARDUINO_ARCH_STM32) && defined(DWT)
+#define ITERATIONS 1000
+#define BENCH_UNIT "cycles"
+static void counterBegin(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+static uint32_t counterRead(void) { return DWT->CYCCNT; }
+#else
+#include <chrono>
+#define ITERATIONS 100000
+#define BENCH_UNIT "ns"
+static void counterBegin(void) {}
+static uint32_t counterRead(void)
+{
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+// Results are folded into this so the compiler cannot drop the work
+volatile uint32_t sink;
+
+// Inputs change every iteration and are read through volatiles, so the
+// compiler can neither hoist a call out of the loop nor fold it
+#define INPUTS 16
+static DateTime dates[INPUTS];
+static const uint32_t base = 1262304000UL; // 2010-01-01
+const char *volatile date_str = __DATE__;
+const char *volatile time_str = __TIME__;
+static const char *const isos[4] = {"2023-01-21T03:04:05", "1999-12-31T23:59:59",
+                                    "2000-02-29T12:00:00", "2099-07-04T00:00:01"};
+volatile uint8_t input_offset = 0;
+static char buffer[PCF85263_FORMAT_MAX_LEN];
+
+#define BENCH_INPUT(i) dates[((i) + input_offset) % INPUTS]
+
+static void report(const char *name, uint32_t total)
+{
+    char line[96];
+    snprintf(line, sizeof(line), "%s,%lu,%s,%lu,%lu.%02lu", name, (unsigned long)ITERATIONS,
+             BENCH_UNIT, (unsigned long)total, (unsigned long)(total / ITERATIONS),
+             (unsigned long)(total % ITERATIONS * 100 / ITERATIONS));
+    TEST_MESSAGE(line);
+}
+
+#define BENCH(test, name, body)                           \
+    static void test(void)                                \
+    {                                                     \
+        uint32_t start = counterRead();                   \
+        for (uint32_t i = 0; i < ITERATIONS; i++) {       \
+            body;                                         \
+        }                                                 \
+        report(name, counterRead() - start);              \
+    }
+
+BENCH(bench_from_unixtime, "DateTime(uint32_t)", sink += DateTime(base + i * 997331UL).day())
+BENCH(bench_unixtime, "unixtime", sink += BENCH_INPUT(i).unixtime())
+BENCH(bench_secondstime, "secondstime", sink += BENCH_INPUT(i).secondstime())
+BENCH(bench_day_of_the_week, "dayOfTheWeek", sink += BENCH_INPUT(i).dayOfTheWeek())
+BENCH(bench_is_valid, "isValid", sink += BENCH_INPUT(i).isValid())
+BENCH(bench_less, "operator<", sink += BENCH_INPUT(i) < BENCH_INPUT(i + 1))
+BENCH(bench_timespan_add, "TimeSpan add", sink += (BENCH_INPUT(i) + TimeSpan(i)).second())
+BENCH(bench_to_string, "toString(in place)", {
+    strcpy(buffer, "YYYY-MM-DD hh:mm:ss");
+    sink += BENCH_INPUT(i).toString(buffer)[3];
+})
+BENCH(bench_timestamp, "timestamp(char *)", sink += BENCH_INPUT(i).timestamp(buffer, sizeof(buffer))[3])
+BENCH(bench_build_time, "DateTime(__DATE__, __TIME__)", sink += DateTime(date_str, time_str).day())
+BENCH(bench_iso8601, "DateTime(iso8601)", sink += DateTime(isos[(i + input_offset) % 4]).day())
+
+static void bench_format(void)
+{
+    const DateTimeFormat format("YYYY-MM-DD hh:mm:ss");
+    uint32_t start = counterRead();
+    for (uint32_t i = 0; i < ITERATIONS; i++)
+        sink += BENCH_INPUT(i).toString(buffer, sizeof(buffer), format)[3];
+    report("toString(DateTimeFormat)", counterRead() - start);
+}
+
+// Bulk conversion, timed per snapshot
+#define SNAPSHOTS 40    // divides ITERATIONS on both targets
+static uint32_t unixtimes[SNAPSHOTS];
+static uint8_t raw[SNAPSHOTS * PCF85263_RAW_TIME_LEN];
+
+static void bench_encode_times(void)
+{
+    uint32_t start = counterRead();
+    for (uint32_t i = 0; i < ITERATIONS; i += SNAPSHOTS)
+    {
+        unixtimes[input_offset] += 1;
+        PCF85263::encodeTimes(unixtimes, SNAPSHOTS, raw);
+        sink += raw[i % sizeof(raw)];
+    }
+    report("encodeTimes", counterRead() - start);
+}
+
+static void bench_decode_times(void)
+{
+    uint32_t start = counterRead();
+    for (uint32_t i = 0; i < ITERATIONS; i += SNAPSHOTS)
+    {
+        raw[input_offset] ^= 1;
+        PCF85263::decodeTimes(raw, SNAPSHOTS, unixtimes);
+        sink += unixtimes[i % SNAPSHOTS];
+    }
+    report("decodeTimes", counterRead() - start);
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static int runBenchmarks(void)
+{
+    counterBegin();
+    for (uint8_t k = 0; k < INPUTS; k++)
+        dates[k] = DateTime(base + k * 97331711UL);
+    for (uint8_t k = 0; k < SNAPSHOTS; k++)
+        unixtimes[k] = base + k * 48271933UL;
+
+    UNITY_BEGIN();
+    TEST_MESSAGE("name,iterations,unit,total,per_op");
+    RUN_TEST(bench_from_unixtime);
+    RUN_TEST(bench_unixtime);
+    RUN_TEST(bench_secondstime);
+    RUN_TEST(bench_day_of_the_week);
+    RUN_TEST(bench_is_valid);
+    RUN_TEST(bench_less);
+    RUN_TEST(bench_timespan_add);
+    RUN_TEST(bench_to_string);
+    RUN_TEST(bench_format);
+    RUN_TEST(bench_timestamp);
+    RUN_TEST(bench_build_time);
+    RUN_TEST(bench_iso8601);
+    RUN_TEST(bench_encode_times);
+    RUN_TEST(bench_decode_times);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO_ARCH_STM32
+void setup(void)
+{
+    delay(2000);    // let the test runner open the port
+    runBenchmarks();
+}
+
+void loop(void)
+{
+}
+#else
+int main(void)
+{
+    return runBenchmarks();
+}
+#endif
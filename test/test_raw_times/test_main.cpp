@@ -0,0 +1,73 @@
+// Round trip of PCF85263::encodeTimes() and decodeTimes() over the whole
+// range of the device, 2000--2099, checked against DateTime.
+#include <unity.h>
+#include <PCF85263.h>
+
+#define FIRST_TIME  946684800UL     // 2000-01-01 00:00:00
+#define LAST_TIME   4102444799UL    // 2099-12-31 23:59:59
+#define STRIDE      7777UL          // odd, so every second of the day is hit eventually
+#define BATCH       64
+
+static uint8_t bcd(uint8_t value) { return value + 6 * (value / 10); }
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static void test_round_trip(void)
+{
+    uint32_t times[BATCH + 1], decoded[BATCH + 1];
+    uint8_t raw[(BATCH + 1) * PCF85263_RAW_TIME_LEN];
+    uint32_t t = FIRST_TIME;
+    bool done = false;
+    while (!done)
+    {
+        size_t n = 0;
+        for (; n < BATCH && !done; n++)
+        {
+            times[n] = t;
+            done = LAST_TIME - t < STRIDE;
+            t += STRIDE;
+        }
+        if (done)
+            times[n++] = LAST_TIME;
+
+        PCF85263::encodeTimes(times, n, raw);
+        PCF85263::decodeTimes(raw, n, decoded);
+        for (size_t i = 0; i < n; i++)
+        {
+            DateTime dt(times[i]);
+            const uint8_t *r = raw + i * PCF85263_RAW_TIME_LEN;
+            TEST_ASSERT_EQUAL_HEX8(bcd(dt.second()), r[0]);
+            TEST_ASSERT_EQUAL_HEX8(bcd(dt.minute()), r[1]);
+            TEST_ASSERT_EQUAL_HEX8(bcd(dt.hour()), r[2]);
+            TEST_ASSERT_EQUAL_HEX8(bcd(dt.day()), r[3]);
+            TEST_ASSERT_EQUAL_HEX8(dt.dayOfTheWeek(), r[4]);
+            TEST_ASSERT_EQUAL_HEX8(bcd(dt.month()), r[5]);
+            TEST_ASSERT_EQUAL_HEX8(bcd(dt.year() - 2000), r[6]);
+            TEST_ASSERT_EQUAL_UINT32(times[i], decoded[i]);
+        }
+    }
+}
+
+static void test_decode_ignores_status_bits(void)
+{
+    // OS flag in SECOND and the unused top bits must not leak into the result
+    uint8_t raw[PCF85263_RAW_TIME_LEN] = {0x80 | 0x56, 0x80 | 0x34, 0xC0 | 0x12,
+                                          0xC0 | 0x29, 0xF8 | 0x04, 0xE0 | 0x02, 0x24};
+    uint32_t decoded;
+    PCF85263::decodeTimes(raw, 1, &decoded);
+    TEST_ASSERT_EQUAL_UINT32(DateTime(2024, 2, 29, 12, 34, 56).unixtime(), decoded);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_decode_ignores_status_bits);
+    return UNITY_END();
+}
@@ -0,0 +1,331 @@
+// Bus traffic budgets of the driver, measured on the simulated device.
+// Run with `pio test -e native`; a call that needs more transfers than its
+// budget fails the test.
+#include <unity.h>
+#include <PCF85263.h>
+#include <PCF85263Sim.h>
+#include <PCF85263Scheduler.h>
+#include <PCF85263Calibrator.h>
+
+static PCF85263_SimTransport sim;
+static PCF85263 rtc;
+static PCF85263_BusCounters before;
+
+void setUp(void)
+{
+    sim.powerOn();
+    rtc.begin(sim, true);
+    before = sim.counters();
+}
+
+void tearDown(void)
+{
+}
+
+static uint32_t transactions(void)
+{
+    uint32_t used = sim.since(before).transactions;
+    before = sim.counters();
+    return used;
+}
+
+static void test_begin(void)
+{
+    PCF85263 fresh;
+    before = sim.counters();
+    TEST_ASSERT_TRUE(fresh.begin(sim, true));
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(3, transactions());
+}
+
+static void test_configure(void)
+{
+    rtc.configure();
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(2, transactions());
+}
+
+static void test_adjust_and_now(void)
+{
+    rtc.adjust(DateTime(2023, 1, 21, 3, 0, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, transactions());
+
+    sim.advance(250);
+    DateTime now = rtc.now();
+    TEST_ASSERT_EQUAL_UINT32(1, transactions());
+    TEST_ASSERT_EQUAL_UINT32(DateTime(2023, 1, 21, 3, 0, 2).unixtime(), now.unixtime());
+}
+
+static void test_now_fails_without_device(void)
+{
+    rtc.adjust(DateTime(2023, 1, 21, 3, 0, 0));
+    TEST_ASSERT_TRUE(rtc.now().isValid());
+    sim.present = false;
+    TEST_ASSERT_FALSE(rtc.now().isValid());
+    TEST_ASSERT_FALSE(rtc.nowPrecise().isValid());
+    TEST_ASSERT_TRUE(rtc.readStopwatch() == PCF85263_STOPWATCH_INVALID);
+    rtc.setConsistentRead(true);
+    TEST_ASSERT_FALSE(rtc.now().isValid());
+    TEST_ASSERT_EQUAL_UINT8(PCF85263_ERR_NACK_ADDR, sim.last_error());
+    sim.present = true;
+    rtc.setConsistentRead(false);
+}
+
+static void test_now_precise(void)
+{
+    rtc.enableHundredths(true);
+    rtc.adjust(DateTime(2023, 1, 21, 3, 0, 0));
+    sim.advance(125);
+    transactions();
+    DateTimeMs now = rtc.nowPrecise();
+    TEST_ASSERT_EQUAL_UINT32(1, transactions());
+    TEST_ASSERT_EQUAL_UINT8(25, now.hundredth());
+}
+
+static void test_consistent_read(void)
+{
+    rtc.setConsistentRead(true);
+    rtc.adjust(DateTime(2023, 1, 21, 3, 0, 59));
+    sim.advance(99);
+    transactions();
+    DateTime now = rtc.now();
+    TEST_ASSERT_EQUAL_UINT32(2, transactions());
+    TEST_ASSERT_EQUAL_UINT32(DateTime(2023, 1, 21, 3, 0, 59).unixtime(), now.unixtime());
+    rtc.setConsistentRead(false);
+}
+
+static void test_set_interrupts(void)
+{
+    rtc.setInterrupts(PCF85263_INT_PULSE | PCF85263_INT_ALARM1, IntSources(PCF85263_INT_BATTERY));
+    TEST_ASSERT_EQUAL_UINT32(1, transactions());
+    TEST_ASSERT_EQUAL_HEX8(0x90, sim.registers[PCF85263_INTAEN]);
+    TEST_ASSERT_EQUAL_HEX8(0x02, sim.registers[PCF85263_INTBEN]);
+
+    rtc.setINTA(true, false, false, true, true, false, false, false);
+    TEST_ASSERT_EQUAL_UINT32(1, transactions());
+}
+
+static void test_transaction(void)
+{
+    rtc.beginTransaction();
+    rtc.setOffsetValue(-3);
+    rtc.setLoadCaps(2);
+    rtc.setInterrupts(PCF85263_INT_PULSE | PCF85263_INT_ALARM1, IntSources());
+    rtc.stop();
+    rtc.start();
+    TEST_ASSERT_EQUAL_UINT32(0, transactions());
+    TEST_ASSERT_TRUE(rtc.commit());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(2, transactions());
+}
+
+static void test_uncached_transaction_reads_fresh(void)
+{
+    PCF85263 uncached;
+    TEST_ASSERT_TRUE(uncached.begin(sim, false));
+    uncached.getOffsetMode();
+    sim.registers[PCF85263_OSC] |= 0x40;    // changed after the last read
+    uncached.beginTransaction();
+    uncached.setLoadCaps(2);
+    uncached.commit();
+    TEST_ASSERT_EQUAL_HEX8(0x40, sim.registers[PCF85263_OSC] & 0x40);
+    TEST_ASSERT_EQUAL_HEX8(2, sim.registers[PCF85263_OSC] & 0x03);
+}
+
+static void test_commit_leaves_watchdog_and_ram(void)
+{
+    rtc.configureWatchdog(5, PCF85263::WD_STEP_1S);
+    rtc.writeRam(0x5A);
+    sim.registers[PCF85263_RAM] = 0xA5;     // changed behind the cache
+    rtc.beginTransaction();
+    rtc.setInterrupts(PCF85263::INT_B, IntSources(PCF85263_INT_ALARM1));
+    rtc.stop();
+    transactions();
+    sim.resetCounters();
+    before = sim.counters();
+    rtc.commit();
+    // INTB_enable and STOP_enable, neither bridged over RAM and WD
+    TEST_ASSERT_EQUAL_UINT32(2, transactions());
+    TEST_ASSERT_EQUAL_UINT32(4, sim.counters().bytes_written);
+    TEST_ASSERT_EQUAL_HEX8(0xA5, sim.registers[PCF85263_RAM]);
+}
+
+static void test_watchdog_kick(void)
+{
+    PCF85263 fresh;
+    TEST_ASSERT_TRUE(fresh.begin(sim, false));
+    transactions();
+    TEST_ASSERT_FALSE(fresh.kick());
+    TEST_ASSERT_EQUAL_UINT32(0, transactions());
+
+    fresh.configureWatchdog(5, PCF85263::WD_STEP_1S);
+    fresh.invalidateCache();
+    transactions();
+    TEST_ASSERT_TRUE(fresh.kick());
+    TEST_ASSERT_EQUAL_UINT32(2, sim.since(before).bytes_written);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.since(before).bytes_read);
+    TEST_ASSERT_EQUAL_UINT32(1, transactions());
+}
+
+static void test_alarms(void)
+{
+    rtc.setAlarms(AlarmSpec::everyMinuteAt(30), AlarmSpec::weeklyAt(1, 6, 0));
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(2, transactions());
+    AlarmSpec a1, a2;
+    TEST_ASSERT_TRUE(rtc.getAlarms(a1, a2));
+    TEST_ASSERT_EQUAL_UINT32(1, transactions());
+    TEST_ASSERT_EQUAL_UINT8(30, a1.second);
+}
+
+static void test_timestamps(void)
+{
+    PCF85263_Timestamps ts;
+    TEST_ASSERT_TRUE(rtc.readAllTimestamps(ts));
+    TEST_ASSERT_EQUAL_UINT32(1, transactions());
+}
+
+static void test_reads_keep_pending_writes(void)
+{
+    PCF85263_Timestamps ts;
+    AlarmSpec a1, a2;
+    rtc.beginTransaction();
+    rtc.setTimestampModes(PCF85263::TSR1_LAST_TS, PCF85263::TSR2_LAST_VDD, PCF85263::TSR3_OFF);
+    rtc.setAlarm1(AlarmSpec::everyMinuteAt(30));
+    TEST_ASSERT_TRUE(rtc.readAllTimestamps(ts));
+    TEST_ASSERT_TRUE(rtc.getAlarms(a1, a2));
+    TEST_ASSERT_TRUE(rtc.syncCache());
+    TEST_ASSERT_TRUE(rtc.commit());
+    TEST_ASSERT_EQUAL_HEX8(0x0E, sim.registers[PCF85263_TSTMP_Control]);
+    TEST_ASSERT_EQUAL_HEX8(PCF85263_ALARM_SECOND, sim.registers[PCF85263_ALMEN] & PCF85263_ALMEN_ALARM1);
+}
+
+static void test_tick_follows_periodic_rate(void)
+{
+    rtc.adjust(DateTime(2024, 5, 6, 12, 0, 25));
+    TEST_ASSERT_TRUE(rtc.attachSecondTick(3, 0, PCF85263::PERIODIC_MINUTE));
+    transactions();
+    shimInterruptHandler()();
+    TEST_ASSERT_EQUAL_UINT32(DateTime(2024, 5, 6, 12, 1, 0).unixtime(), rtc.tickNow().unixtime());
+    TEST_ASSERT_EQUAL_UINT32(0, transactions());
+
+    sim.advance(100 * 60);
+    rtc.setPeriodicInterrupt(PCF85263::PERIODIC_SECOND);
+    shimInterruptHandler()();
+    TEST_ASSERT_EQUAL_UINT32(DateTime(2024, 5, 6, 12, 1, 26).unixtime(), rtc.tickNow().unixtime());
+
+    rtc.setPeriodicInterrupt(PCF85263::PERIODIC_OFF);
+    TEST_ASSERT_TRUE(shimInterruptHandler() == NULL);
+    TEST_ASSERT_FALSE(rtc.resyncSecondTick());
+}
+
+static uint8_t handled;
+
+static void on_flag(uint8_t flag, const DateTime *)
+{
+    handled |= flag;
+}
+
+static void test_service_interrupt(void)
+{
+    rtc.adjust(DateTime(2024, 5, 6, 12, 0, 25));
+    rtc.setTimestampModes(PCF85263::TSR1_LAST_TS, PCF85263::TSR2_OFF, PCF85263::TSR3_OFF);
+    rtc.setAlarm1(AlarmSpec::everyMinuteAt(30));
+    sim.advance(300);
+    sim.triggerTimestamp();
+    sim.advance(300);
+    handled = 0;
+    rtc.onInterrupt(PCF85263_FLAG_ALARM1 | PCF85263_FLAG_TSR1, on_flag);
+    transactions();
+
+    uint8_t flags = rtc.serviceInterrupt();
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(2, transactions());
+    TEST_ASSERT_EQUAL_HEX8(PCF85263_FLAG_ALARM1 | PCF85263_FLAG_TSR1, flags);
+    TEST_ASSERT_EQUAL_HEX8(PCF85263_FLAG_ALARM1 | PCF85263_FLAG_TSR1, handled);
+    TEST_ASSERT_EQUAL_HEX8(0, sim.registers[PCF85263_FLAGS]);
+    rtc.onInterrupt(0xFF, NULL);
+}
+
+static uint8_t jobs_run;
+
+static void on_job(uint8_t, const DateTime &)
+{
+    jobs_run++;
+}
+
+static void test_scheduler_ignores_failed_read(void)
+{
+    PCF85263Scheduler scheduler;
+    rtc.adjust(DateTime(2024, 5, 6, 12, 0, 25));
+    scheduler.begin(rtc);
+    TEST_ASSERT_NOT_EQUAL(PCF85263_SCHEDULER_NO_JOB, scheduler.at(DateTime(2024, 5, 6, 12, 0, 35), on_job));
+    TEST_ASSERT_NOT_EQUAL(PCF85263_SCHEDULER_NO_JOB, scheduler.every(TimeSpan(60), on_job));
+    uint8_t alarms[PCF85263_ALMEN - PCF85263_ALM1_SECONDS + 1];
+    memcpy(alarms, &sim.registers[PCF85263_ALM1_SECONDS], sizeof(alarms));
+    jobs_run = 0;
+
+    sim.present = false;
+    TEST_ASSERT_EQUAL_UINT8(0, scheduler.service(true));
+    TEST_ASSERT_EQUAL_UINT8(PCF85263_SCHEDULER_NO_JOB, scheduler.every(TimeSpan(60), on_job));
+    TEST_ASSERT_EQUAL_UINT8(PCF85263_SCHEDULER_NO_JOB, scheduler.at(DateTime(2024, 5, 6, 13, 0, 0), on_job));
+    TEST_ASSERT_TRUE(scheduler.cancel(0));
+    TEST_ASSERT_TRUE(scheduler.pending());
+    sim.present = true;
+    TEST_ASSERT_EQUAL_UINT8(0, jobs_run);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(alarms, &sim.registers[PCF85263_ALM1_SECONDS], sizeof(alarms));
+
+    // the periodic job stays on its grid once the bus is back
+    sim.advance(100 * 60);
+    TEST_ASSERT_EQUAL_UINT8(1, scheduler.service());
+    DateTime next;
+    TEST_ASSERT_TRUE(scheduler.next(next));
+    TEST_ASSERT_EQUAL_UINT32(DateTime(2024, 5, 6, 12, 2, 25).unixtime(), next.unixtime());
+}
+
+static void test_calibrator_drops_failed_samples(void)
+{
+    PCF85263 uncached;
+    PCF85263Calibrator calibrator;
+    TEST_ASSERT_TRUE(uncached.begin(sim, false));
+    uncached.enableHundredths(true);
+    uncached.adjust(DateTime(2024, 5, 6, 12, 0, 0));
+    uncached.setOffsetValue(0);
+    calibrator.begin(uncached);
+    TEST_ASSERT_TRUE(calibrator.start(0));
+
+    sim.advance(100UL * 3600);
+    sim.present = false;
+    TEST_ASSERT_FALSE(calibrator.measure(3600036));
+    sim.present = true;
+    TEST_ASSERT_FALSE(calibrator.apply(3600036));
+    TEST_ASSERT_EQUAL_HEX8(0, sim.registers[PCF85263_OFFSET]);
+
+    // 10 ppm slow: one read each of OFFSET and OSC, the write, the new start
+    TEST_ASSERT_TRUE(calibrator.start(0));
+    sim.advance(100UL * 3600);
+    TEST_ASSERT_TRUE(calibrator.measure(3600036));
+    transactions();
+    TEST_ASSERT_FALSE(calibrator.apply(3600036));
+    TEST_ASSERT_EQUAL_UINT32(4, transactions());
+    TEST_ASSERT_EQUAL_HEX8(4, sim.registers[PCF85263_OFFSET]);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_begin);
+    RUN_TEST(test_configure);
+    RUN_TEST(test_adjust_and_now);
+    RUN_TEST(test_now_fails_without_device);
+    RUN_TEST(test_now_precise);
+    RUN_TEST(test_consistent_read);
+    RUN_TEST(test_set_interrupts);
+    RUN_TEST(test_transaction);
+    RUN_TEST(test_uncached_transaction_reads_fresh);
+    RUN_TEST(test_commit_leaves_watchdog_and_ram);
+    RUN_TEST(test_watchdog_kick);
+    RUN_TEST(test_alarms);
+    RUN_TEST(test_timestamps);
+    RUN_TEST(test_reads_keep_pending_writes);
+    RUN_TEST(test_tick_follows_periodic_rate);
+    RUN_TEST(test_service_interrupt);
+    RUN_TEST(test_scheduler_ignores_failed_read);
+    RUN_TEST(test_calibrator_drops_failed_samples);
+    return UNITY_END();
+}